@@ -0,0 +1,138 @@
+#include "TestScenes.h"
+
+// Headless entry point for render nodes without a display:
+// DreamRenderBatch [-scene name] [-spp samples] [-pass samples] [-noise threshold] [-minspp samples] [-time seconds] [-tile size] [-threads count] [-integrator megakernel|wavefront] [-sampler independent|sobol|owen|bluenoise]
+// [-bvh low|medium|high] [-compact 0|1] [-robust 0|1] [-embreethreads count] [-isa sse4.2|avx|avx2|avx512] [-o output]
+int main(int argc, char* argv[]) {
+	std::map<std::string, RendererParams(*)(IntegratorType, const EmbreeParams&)> scenes = {
+		{ "diningroom_meshlight", TestScenes::Diningroom_MeshLight },
+		{ "diningroom_environmentlight", TestScenes::Diningroom_EnvironmentLight },
+		{ "subsurface", TestScenes::Subsurface },
+		{ "surface", TestScenes::Surface },
+		{ "cornellbox", TestScenes::Cornellbox },
+		{ "camera_high", TestScenes::Camera_high },
+		{ "instancing", TestScenes::Instancing }
+	};
+
+	std::string sceneName = "diningroom_meshlight";
+	std::string output = "output.png";
+	int spp = 64;
+	int sppPerPass = 4;
+	float noiseThreshold = 0.0f;
+	int minSamples = 16;
+	double timeBudget = 0.0;
+	int tileSize = 16;
+	int threads = 0;
+	IntegratorType integratorType = IntegratorType::VolumetricPathTracingIntegrator;
+	std::shared_ptr<Sampler> sampler = NULL;
+	EmbreeParams embree;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i];
+		if (arg == "-scene") {
+			sceneName = argv[i + 1];
+		}
+		else if (arg == "-spp") {
+			spp = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "-pass") {
+			sppPerPass = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "-noise") {
+			noiseThreshold = std::atof(argv[i + 1]);
+		}
+		else if (arg == "-minspp") {
+			minSamples = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "-time") {
+			timeBudget = std::atof(argv[i + 1]);
+		}
+		else if (arg == "-tile") {
+			tileSize = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "-threads") {
+			threads = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "-integrator") {
+			std::string name = argv[i + 1];
+			if (name == "megakernel") {
+				integratorType = IntegratorType::VolumetricPathTracingIntegrator;
+			}
+			else if (name == "wavefront") {
+				integratorType = IntegratorType::WavefrontPathTracingIntegrator;
+			}
+			else {
+				std::cout << "Unknown integrator " << name << std::endl;
+
+				return 1;
+			}
+		}
+		else if (arg == "-sampler") {
+			std::map<std::string, SamplerType> samplers = {
+				{ "independent", SamplerType::IndependentSampler },
+				{ "sobol", SamplerType::SimpleSobolSampler },
+				{ "owen", SamplerType::OwenSobolSampler },
+				{ "bluenoise", SamplerType::BlueNoiseSampler }
+			};
+			auto type = samplers.find(argv[i + 1]);
+			if (type == samplers.end()) {
+				std::cout << "Unknown sampler " << argv[i + 1] << std::endl;
+
+				return 1;
+			}
+			sampler = Sampler::Create(SamplerParams{ type->second, 0 });
+		}
+		else if (arg == "-bvh") {
+			std::map<std::string, BuildQualityType> qualities = {
+				{ "low", BuildQualityType::LowBuildQuality },
+				{ "medium", BuildQualityType::MediumBuildQuality },
+				{ "high", BuildQualityType::HighBuildQuality }
+			};
+			auto quality = qualities.find(argv[i + 1]);
+			if (quality == qualities.end()) {
+				std::cout << "Unknown BVH quality " << argv[i + 1] << std::endl;
+
+				return 1;
+			}
+			embree.quality = quality->second;
+		}
+		else if (arg == "-compact") {
+			embree.compact = std::atoi(argv[i + 1]) != 0;
+		}
+		else if (arg == "-robust") {
+			embree.robust = std::atoi(argv[i + 1]) != 0;
+		}
+		else if (arg == "-embreethreads") {
+			embree.threads = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "-isa") {
+			embree.isa = argv[i + 1];
+		}
+		else if (arg == "-o") {
+			output = argv[i + 1];
+		}
+		else {
+			std::cout << "Unknown argument " << arg << std::endl;
+
+			return 1;
+		}
+	}
+
+	auto scene = scenes.find(sceneName);
+	if (scene == scenes.end()) {
+		std::cout << "Unknown scene " << sceneName << std::endl;
+
+		return 1;
+	}
+
+	auto params = scene->second(integratorType, embree);
+	if (sampler != NULL) {
+		params.integrator->SetSampler(sampler);
+	}
+	params.integrator->SetAdaptiveSampling(noiseThreshold, minSamples);
+	params.integrator->SetScheduler(std::make_shared<TileScheduler>(tileSize, TileOrderType::MortonTileOrder, threads));
+	auto renderer = std::make_shared<Batch>(params.integrator, params.post, spp, timeBudget, output, sppPerPass);
+	renderer->Run();
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "Interactive.h"
+
+unsigned int Interactive::GetTextureRGB32F(int w, int h) {
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, w, h, 0, GL_RGB, GL_FLOAT, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return texture;
+}
+
+Interactive::Interactive(std::shared_ptr<Integrator> inte, std::shared_ptr<PostProcessing> p) : Renderer(inte, p) {
+	frameCounter = 0;
+
+#pragma region InitOpenGL
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	window = glfwCreateWindow(width, height, "DreamRender", NULL, NULL);
+	if (window == NULL) {
+		std::cout << "Init Window failed!" << std::endl;
+		glfwTerminate();
+
+		assert(0);
+	}
+	glfwMakeContextCurrent(window);
+
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		std::cout << "Init glad failed!" << std::endl;
+
+		assert(0);
+	}
+
+	glViewport(0, 0, width, height);
+#pragma endregion
+
+#pragma region PipelineConfiguration
+	// Accumulation happens in the film, the window only shows the resolved image
+	Shader shader("shader/VertexShader.vert", "shader/OutputShader.frag");
+
+	outputPass.program = shader.ID;
+	outputPass.width = width;
+	outputPass.height = height;
+	outputPass.BindData(true);
+#pragma endregion
+}
+
+Interactive::~Interactive() {
+	glfwDestroyWindow(window);
+	glfwTerminate();
+}
+
+void Interactive::Run() {
+	RGBSpectrum* nowTexture = new RGBSpectrum[width * height];
+	nowFrame = GetTextureRGB32F(width, height);
+
+	while (!glfwWindowShouldClose(window)) {
+		t2 = clock();
+		dt = (double)(t2 - t1) / CLOCKS_PER_SEC;
+		fps = 1.0 / dt;
+		std::cout << "\r";
+		std::cout << std::fixed << std::setprecision(2) << "FPS : " << fps << "    FrameCounter: " << frameCounter;
+		t1 = t2;
+
+		integrator->RenderImage(1, film);
+		film->Resolve(post, nowTexture);
+		frameCounter++;
+
+		glBindTexture(GL_TEXTURE_2D, nowFrame);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, width, height, 0, GL_RGB, GL_FLOAT, nowTexture);
+
+		outputPass.Draw({ nowFrame });
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+	if (nowTexture != NULL) {
+		delete[] nowTexture;
+		nowTexture = NULL;
+	}
+}
\ No newline at end of file
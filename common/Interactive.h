@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glfw/glfw3.h>
+#include "Renderer.h"
+#include "Shader.h"
+#include "RenderPass.h"
+
+class Interactive : public Renderer {
+public:
+	Interactive(std::shared_ptr<Integrator> inte, std::shared_ptr<PostProcessing> p);
+
+	~Interactive();
+
+	virtual void Run() override;
+
+private:
+	unsigned int GetTextureRGB32F(int w, int h);
+
+private:
+	GLFWwindow* window;
+	unsigned int nowFrame;
+	clock_t t1, t2;
+	double dt, fps;
+	unsigned int frameCounter;
+	RenderPass outputPass;
+};
@@ -0,0 +1,45 @@
+#include "AssetLoader.h"
+
+AssetLoader::AssetLoader(int threads) : stopping(false) {
+	int numThreads = threads > 0 ? threads : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	workers.reserve(numThreads);
+	for (int i = 0; i < numThreads; i++) {
+		workers.emplace_back(&AssetLoader::Work, this);
+	}
+}
+
+AssetLoader::~AssetLoader() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+std::shared_future<TriangleMesh*> AssetLoader::LoadMesh(std::shared_ptr<Material> m, const std::string& file, const Transform& trans,
+	std::shared_ptr<Medium> out, std::shared_ptr<Medium> in) {
+	return Submit([m, file, trans, out, in]() {
+		return new TriangleMesh(m, file, trans, out, in);
+	});
+}
+
+void AssetLoader::Work() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this]() {
+				return stopping || !tasks.empty();
+			});
+			if (tasks.empty()) {
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Utils.h"
+#include "Shape.h"
+#include "Texture.h"
+
+// Decodes meshes and textures on a pool of worker threads while the scene is being described.
+// Every load returns a future; the scene builder resolves them in the order it adds shapes, so geometry IDs stay deterministic.
+class AssetLoader {
+public:
+	// threads = 0 uses every hardware thread of the machine
+	AssetLoader(int threads = 0);
+
+	// Finishes the queued loads before the workers exit
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	inline int GetThreads() const {
+		return static_cast<int>(workers.size());
+	}
+
+	std::shared_future<TriangleMesh*> LoadMesh(std::shared_ptr<Material> m, const std::string& file, const Transform& trans,
+		std::shared_ptr<Medium> out = NULL, std::shared_ptr<Medium> in = NULL);
+
+	// T is a texture constructed from a file path, Image or Hdr
+	template<typename T>
+	std::shared_future<std::shared_ptr<T>> LoadTexture(const std::string& file) {
+		return Submit([file]() {
+			return std::make_shared<T>(file);
+		});
+	}
+
+	// Run func on a worker and return its result as a future
+	template<typename Func>
+	auto Submit(Func func) -> std::shared_future<decltype(func())> {
+		using Result = decltype(func());
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+		std::shared_future<Result> result = task->get_future().share();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back([task]() {
+				(*task)();
+			});
+		}
+		wake.notify_one();
+
+		return result;
+	}
+
+private:
+	void Work();
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping;
+};
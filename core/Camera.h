@@ -27,7 +27,7 @@ class Camera {
 public:
 	Camera(CameraType type, std::shared_ptr<Medium> med = NULL) : m_type(type), medium(med) {}
 
-	virtual Ray GenerateRay(std::shared_ptr<Sampler> sampler, float x, float y) = 0;
+	virtual Ray GenerateRay(Sampler& sampler, float x, float y) = 0;
 
 	inline CameraType GetType() const {
 		return m_type;
@@ -53,14 +53,14 @@ class Pinhole : public Camera {
 public:
 	Pinhole(const Point3f& lookfrom, const Point3f& lookat, const Vector3f& vup, float znear, float vfov, float aspect, std::shared_ptr<Medium> med = NULL);
 
-	virtual Ray GenerateRay(std::shared_ptr<Sampler> sampler, float x, float y) override;
+	virtual Ray GenerateRay(Sampler& sampler, float x, float y) override;
 };
 
 class Thinlens : public Camera {
 public:
 	Thinlens(const Point3f& lookfrom, const Point3f& lookat, const Vector3f& vup, float znear, float vfov, float aspect, float aperture, std::shared_ptr<Medium> med = NULL);
 
-	virtual Ray GenerateRay(std::shared_ptr<Sampler> sampler, float x, float y) override;
+	virtual Ray GenerateRay(Sampler& sampler, float x, float y) override;
 
 private:
 	float lens_radius;
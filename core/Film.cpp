@@ -0,0 +1,208 @@
+#include "Film.h"
+
+// Converged tiles get a sample per pixel again once they drop below this fraction of the average spp
+constexpr int AdaptiveRevisitRatio = 8;
+// Upper bound of the samples per pixel a single tile takes from a pass, in multiples of the pass spp
+constexpr int AdaptiveMaxPassScale = 4;
+
+Film::Film(int w, int h) : width(w), height(h), pixels(w * h), passSamples(w * h, 1) {}
+
+void Film::Clear() {
+	std::fill(pixels.begin(), pixels.end(), FilmPixel());
+}
+
+void Film::AddSample(int x, int y, const RGBSpectrum& color, float weight) {
+	FilmPixel& pixel = pixels[y * width + x];
+	for (int c = 0; c < 3; c++) {
+		pixel.rgb[c] += static_cast<double>(weight) * color[c];
+	}
+	pixel.weight += weight;
+
+	if (pixel.samples % 2 == 0) {
+		for (int c = 0; c < 3; c++) {
+			pixel.half[c] += static_cast<double>(weight) * color[c];
+		}
+		pixel.halfWeight += weight;
+	}
+	pixel.samples++;
+}
+
+RGBSpectrum Film::GetPixel(int x, int y) const {
+	const FilmPixel& pixel = pixels[y * width + x];
+	if (pixel.weight == 0.0) {
+		return RGBSpectrum(0.0f);
+	}
+
+	RGBSpectrum color;
+	double invWeight = 1.0 / pixel.weight;
+	for (int c = 0; c < 3; c++) {
+		color[c] = static_cast<float>(pixel.rgb[c] * invWeight);
+	}
+
+	return color;
+}
+
+float Film::GetRelativeError(int x, int y) const {
+	const FilmPixel& pixel = pixels[y * width + x];
+	if (pixel.samples < 2 || pixel.weight == 0.0 || pixel.halfWeight == 0.0) {
+		return Infinity;
+	}
+
+	double diff = 0.0;
+	double sum = 0.0;
+	for (int c = 0; c < 3; c++) {
+		double all = pixel.rgb[c] / pixel.weight;
+		double half = pixel.half[c] / pixel.halfWeight;
+		diff += std::abs(all - half);
+		sum += all;
+	}
+
+	// The offset keeps dark pixels from asking for samples forever
+	return static_cast<float>(diff / (sum + 0.01));
+}
+
+float Film::GetRelativeError(const Tile& tile) const {
+	double error = 0.0;
+	for (int j = tile.y0; j < tile.y1; j++) {
+		for (int i = tile.x0; i < tile.x1; i++) {
+			error += GetRelativeError(i, j);
+		}
+	}
+
+	return static_cast<float>(error / ((tile.x1 - tile.x0) * (tile.y1 - tile.y0)));
+}
+
+bool Film::IsConverged(const Tile& tile, float threshold, int minSamples) const {
+	if (threshold <= 0.0f) {
+		return false;
+	}
+
+	for (int j = tile.y0; j < tile.y1; j++) {
+		for (int i = tile.x0; i < tile.x1; i++) {
+			if (GetSampleCount(i, j) < std::max(minSamples, 2)) {
+				return false;
+			}
+		}
+	}
+
+	return GetRelativeError(tile) < threshold;
+}
+
+int Film::CountConverged(const std::vector<Tile>& tiles, float threshold, int minSamples) const {
+	int count = 0;
+	for (const Tile& tile : tiles) {
+		if (IsConverged(tile, threshold, minSamples)) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+void Film::AllocateSamples(const std::vector<Tile>& tiles, int spp, float threshold, int minSamples) {
+	if (threshold <= 0.0f) {
+		std::fill(passSamples.begin(), passSamples.end(), spp);
+
+		return;
+	}
+
+	uint64_t total = 0;
+	for (const FilmPixel& pixel : pixels) {
+		total += pixel.samples;
+	}
+	double meanSpp = static_cast<double>(total) / (width * height);
+
+	int64_t budget = static_cast<int64_t>(spp) * width * height;
+	std::vector<int> tileSpp(tiles.size(), 0);
+	std::vector<std::pair<float, int>> noisy;
+	double errorSum = 0.0;
+	for (int t = 0; t < tiles.size(); t++) {
+		const Tile& tile = tiles[t];
+		int area = (tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+
+		uint32_t minCount = std::numeric_limits<uint32_t>::max();
+		uint64_t samples = 0;
+		for (int j = tile.y0; j < tile.y1; j++) {
+			for (int i = tile.x0; i < tile.x1; i++) {
+				minCount = std::min(minCount, GetSampleCount(i, j));
+				samples += GetSampleCount(i, j);
+			}
+		}
+
+		if (minCount < std::max(minSamples, 2)) {
+			tileSpp[t] = spp;
+			budget -= static_cast<int64_t>(spp) * area;
+		}
+		else if (GetRelativeError(tile) < threshold) {
+			if (static_cast<double>(samples) / area * AdaptiveRevisitRatio < meanSpp) {
+				tileSpp[t] = 1;
+				budget -= area;
+			}
+		}
+		else {
+			float error = GetRelativeError(tile);
+			noisy.push_back({ error, t });
+			errorSum += error;
+		}
+	}
+
+	// Highest error first, every tile takes its share of what the tiles before it left over
+	std::sort(noisy.begin(), noisy.end(), std::greater<std::pair<float, int>>());
+	for (const auto& n : noisy) {
+		const Tile& tile = tiles[n.second];
+		int area = (tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+
+		double share = budget > 0 && errorSum > 0.0 ? budget * (n.first / errorSum) / area : 0.0;
+		int samples = glm::clamp(static_cast<int>(share + 0.5), 1, AdaptiveMaxPassScale * spp);
+		tileSpp[n.second] = samples;
+		budget -= static_cast<int64_t>(samples) * area;
+		errorSum -= n.first;
+	}
+
+	for (int t = 0; t < tiles.size(); t++) {
+		const Tile& tile = tiles[t];
+		for (int j = tile.y0; j < tile.y1; j++) {
+			std::fill(passSamples.begin() + j * width + tile.x0, passSamples.begin() + j * width + tile.x1, tileSpp[t]);
+		}
+	}
+}
+
+void Film::Resolve(std::shared_ptr<PostProcessing> post, RGBSpectrum* image) const {
+	for (int j = 0; j < height; j++) {
+		for (int i = 0; i < width; i++) {
+			image[j * width + i] = post->GetScreenColor(GetPixel(i, j));
+		}
+	}
+}
+
+void Film::ReportSampleCounts(const std::vector<Tile>& tiles) const {
+	if (tiles.size() == 0) {
+		return;
+	}
+
+	uint64_t total = 0;
+	double minSpp = Infinity;
+	double maxSpp = 0.0;
+	int maxIndex = 0;
+	for (int t = 0; t < tiles.size(); t++) {
+		const Tile& tile = tiles[t];
+		uint64_t samples = 0;
+		for (int j = tile.y0; j < tile.y1; j++) {
+			for (int i = tile.x0; i < tile.x1; i++) {
+				samples += GetSampleCount(i, j);
+			}
+		}
+		total += samples;
+
+		double spp = static_cast<double>(samples) / ((tile.x1 - tile.x0) * (tile.y1 - tile.y0));
+		minSpp = std::min(minSpp, spp);
+		if (spp > maxSpp) {
+			maxSpp = spp;
+			maxIndex = t;
+		}
+	}
+
+	const Tile& busiest = tiles[maxIndex];
+	std::cout << std::fixed << std::setprecision(1) << "Samples: " << total << "    Tile spp min/avg/max: " << minSpp << "/"
+		<< static_cast<double>(total) / (width * height) << "/" << maxSpp << "    Busiest tile: (" << busiest.x0 << ", " << busiest.y0 << ")" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Utils.h"
+#include "Spectrum.h"
+#include "PostProcessing.h"
+#include "Scheduler.h"
+
+// Accumulated linear radiance of a pixel, summed in double so long renders do not lose precision
+struct FilmPixel {
+	double rgb[3] = { 0.0, 0.0, 0.0 };
+	double weight = 0.0;
+	// Every other sample again, compared against the full sum for the error estimate
+	double half[3] = { 0.0, 0.0, 0.0 };
+	double halfWeight = 0.0;
+	uint32_t samples = 0;
+};
+
+// CPU framebuffer the integrators accumulate into, tone mapping is only applied on Resolve
+class Film {
+public:
+	Film(int w, int h);
+
+	inline int GetWidth() const {
+		return width;
+	}
+
+	inline int GetHeight() const {
+		return height;
+	}
+
+	inline uint32_t GetSampleCount(int x, int y) const {
+		return pixels[y * width + x].samples;
+	}
+
+	// Samples AllocateSamples gave the pixel for the coming pass
+	inline int GetPassSamples(int x, int y) const {
+		return passSamples[y * width + x];
+	}
+
+	void Clear();
+
+	// Tiles never share pixels, so a pixel is only written by the thread rendering its tile
+	void AddSample(int x, int y, const RGBSpectrum& color, float weight = 1.0f);
+
+	// Weighted mean of the linear radiance
+	RGBSpectrum GetPixel(int x, int y) const;
+
+	// Difference between the mean of all samples and the mean of every other sample, relative to the mean.
+	// The two halves are independent estimates, so a pixel is not judged by the same moments it accumulates
+	float GetRelativeError(int x, int y) const;
+
+	// Mean relative error of the pixels of a tile, Infinity while a pixel has less than two samples
+	float GetRelativeError(const Tile& tile) const;
+
+	// A tile is converged once every pixel has minSamples and its relative error is below threshold
+	bool IsConverged(const Tile& tile, float threshold, int minSamples) const;
+
+	int CountConverged(const std::vector<Tile>& tiles, float threshold, int minSamples) const;
+
+	// Splits a pass of spp samples per pixel over the tiles, threshold = 0 gives every pixel spp.
+	// Tiles below minSamples get spp, the rest of the budget goes to the noisy tiles in the order of their error,
+	// converged tiles are revisited whenever they fall too far behind the average so a missed caustic still shows up
+	void AllocateSamples(const std::vector<Tile>& tiles, int spp, float threshold, int minSamples);
+
+	// Tone mapped display colors, row 0 is the bottom of the image
+	void Resolve(std::shared_ptr<PostProcessing> post, RGBSpectrum* image) const;
+
+	// Samples spent on every tile of the scheduler
+	void ReportSampleCounts(const std::vector<Tile>& tiles) const;
+
+private:
+	int width, height;
+	std::vector<FilmPixel> pixels;
+	std::vector<int> passSamples;
+};
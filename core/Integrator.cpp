@@ -1,5 +1,30 @@
 #include "Integrator.h"
 
+static bool HitNothing(const IntersectionInfo& info) {
+	return info.t == Infinity;
+}
+
+static bool HitLight(const Scene& scene, const IntersectionInfo& info) {
+	return scene.HasShapeFlag(info.geomID, ShapeFlags::EmissiveShape);
+}
+
+static bool HitMediumBoundary(const Scene& scene, const IntersectionInfo& info) {
+	return scene.HasShapeFlag(info.geomID, ShapeFlags::MediumBoundaryShape);
+}
+
+static void UpdateMediumInfo(IntersectionInfo& info, float actual_distance, const Point3f& pre_position, const Vector3f& L) {
+	info.position = pre_position + actual_distance * L;
+	info.t = actual_distance;
+	info.frontFace = true;
+	info.Ng = Vector3f(0.0f);
+	info.Ns = Vector3f(0.0f);
+	info.uv = Point2f(0.0f);
+	info.materialID = -1;
+	info.geomID = -1;
+	info.primID = -1;
+	info.instID = -1;
+}
+
 float Integrator::PowerHeuristic(float pdf1, float pdf2, int beta) {
 	float p1 = pow(pdf1, beta);
 	float p2 = pow(pdf2, beta);
@@ -11,56 +36,52 @@ std::shared_ptr<Integrator> Integrator::Create(const IntegratorParams& params) {
 	if (params.type == IntegratorType::VolumetricPathTracingIntegrator) {
 		return std::make_shared<VolumetricPathTracing>(params.scene, params.sampler, params.filter, params.width, params.height, params.maxBounce);
 	}
+	else if (params.type == IntegratorType::WavefrontPathTracingIntegrator) {
+		return std::make_shared<WavefrontPathTracing>(params.scene, params.sampler, params.filter, params.width, params.height, params.maxBounce);
+	}
 
 	return NULL;
 }
 
-Spectrum VolumetricPathTracing::SolvingIntegrator(Ray& ray, IntersectionInfo& info) {
+Spectrum VolumetricPathTracing::SolvingIntegrator(Ray& ray, IntersectionInfo& info, Sampler& sampler) {
+	return SolvingPath(ray, info, sampler, false);
+}
+
+Spectrum VolumetricPathTracing::SolvingPath(Ray& ray, IntersectionInfo& info, Sampler& sampler, bool traced) {
 	Spectrum radiance(0.0f);
 	Spectrum history(1.0f);
 	Vector3f V = -ray.GetDir();
 	Vector3f L = ray.GetDir();
 	Point3f pre_position = ray.GetOrg();
+	// Last scattering vertex, the light a bsdf or phase sample hits could have been chosen there as well
+	Point3f vertex_position = ray.GetOrg();
+	Vector3f vertex_normal(0.0f);
 	float bp_pdf = 0.0f;// bsdf or phase pdf
 	float mult_trans_pdf = 1.0f;
+	int depth = 0;// path vertices so far, medium boundaries included
+	uint32_t rayMask = RayVisibility::CameraVisibility;// crossing a medium boundary keeps the ray type
+	BoundaryTrace trace;// medium boundaries of the last traversal the path has yet to cross
 
-	auto HitNothing = [](const IntersectionInfo& info) ->bool {
-		return info.t == Infinity;
-	};
+	for (int bounce = 0; bounce < maxBounce; bounce++) {
+		sampler.StartBounce(depth++);
 
-	auto HitLight = [](const IntersectionInfo& info) ->bool {
-		if (info.material == NULL) {
-			return false;
+		// The camera ray may already be traced as part of a packet, or the boundary crossed as part of the last traversal
+		if (!traced && trace.next < trace.count) {
+			info = trace.hits[trace.next++];
 		}
-
-		return info.material->GetType() == MaterialType::DiffuseLightMaterial;
-	};
-
-	auto HitMediumBoundary = [](const IntersectionInfo& info) -> bool {
-		if (info.material == NULL) {
-			return false;
+		else if (!traced) {
+			RTCRayHit rtc_rayhit = MakeRayHit(ray.GetOrg(), ray.GetDir(), 0.0f, Infinity, rayMask);
+			if (scene->HasMediumBoundary()) {
+				scene->TraceRayThroughBoundaries(rtc_rayhit, trace);
+				info = trace.hits[trace.next++];
+			}
+			else {
+				scene->TraceRay(rtc_rayhit, info);
+			}
 		}
+		traced = false;
 
-		return info.material->GetType() == MaterialType::MediumBoundaryMaterial;
-	};
-
-	auto UpdateMediumInfo = [](IntersectionInfo& info, float actual_distance, const Point3f& pre_position, const Vector3f& L) -> void {
-		info.position = pre_position + actual_distance * L;
-		info.t = actual_distance;
-		info.frontFace = true;
-		info.Ng = Vector3f(0.0f);
-		info.Ns = Vector3f(0.0f);
-		info.uv = Point2f(0.0f);
-		info.material = NULL;
-		info.geomID = -1;
-		info.primID = -1;
-	};
-
-	for (int bounce = 0; bounce < maxBounce; bounce++) {
-		RTCRayHit rtc_rayhit = MakeRayHit(ray.GetOrg(), ray.GetDir());
-		scene->TraceRay(rtc_rayhit, info);
-
-		auto medium = info.mi.GetMedium(HitLight(info) ? true : info.frontFace);
+		Medium* medium = scene->GetMedium(info.GetMediumID(HitLight(*scene, info) ? true : info.frontFace));
 		bool scattered = false;
 		float trans_pdf = 0.0f;
 		float actual_distance = 0.0f;
@@ -108,10 +129,10 @@ Spectrum VolumetricPathTracing::SolvingIntegrator(Ray& ray, IntersectionInfo& in
 		}
 
 		if (!scattered) {
-			if (HitLight(info)) {// Hit light
+			if (HitLight(*scene, info)) {// Hit light
 				float misWeight = 1.0f;
 				float light_pdf = 0.0f;
-				Spectrum light_radiance = scene->EvaluateLight(info.geomID, L, light_pdf, info);
+				Spectrum light_radiance = scene->EvaluateLight(info.geomID, L, light_pdf, info, vertex_position, vertex_normal);
 				bp_pdf *= mult_trans_pdf;
 
 				if (bounce != 0) {
@@ -144,7 +165,7 @@ Spectrum VolumetricPathTracing::SolvingIntegrator(Ray& ray, IntersectionInfo& in
 
 				break;
 			}
-			else if (HitMediumBoundary(info)) {// Hit medium boundary
+			else if (HitMediumBoundary(*scene, info)) {// Hit medium boundary
 				V = -L;
 				pre_position = info.position;
 				ray = Ray::SpawnRay(pre_position, L, info.Ng);
@@ -153,12 +174,14 @@ Spectrum VolumetricPathTracing::SolvingIntegrator(Ray& ray, IntersectionInfo& in
 				continue;
 			}
 			else {
+				Material* material = scene->GetMaterial(info.materialID);
+
 				// Sample light
 				float light_pdf = 0.0f, bsdf_pdf = 0.0f;
 				Vector3f lightL;
 				float mult_trans_pdf_nee = 1.0f;
 				Spectrum light_radiance = scene->SampleLightEnvironment(history, lightL, light_pdf, mult_trans_pdf_nee, info, sampler);
-				Spectrum bsdf = info.material->Evaluate(V, lightL, bsdf_pdf, info);
+				Spectrum bsdf = material->Evaluate(V, lightL, bsdf_pdf, info);
 				bsdf_pdf *= mult_trans_pdf_nee;
 				float costheta = std::max(glm::dot(info.Ns, lightL), 0.0f);
 
@@ -169,7 +192,7 @@ Spectrum VolumetricPathTracing::SolvingIntegrator(Ray& ray, IntersectionInfo& in
 				}
 
 				// Sample surface
-				bsdf = info.material->Sample(V, L, bsdf_pdf, info, sampler);
+				bsdf = material->Sample(V, L, bsdf_pdf, info, sampler);
 				bp_pdf = bsdf_pdf;
 				costheta = std::abs(glm::dot(info.Ns, L));
 
@@ -181,17 +204,21 @@ Spectrum VolumetricPathTracing::SolvingIntegrator(Ray& ray, IntersectionInfo& in
 			}
 		}
 
-		// Update information
+		// Update information, hits further along the old direction are dropped
 		V = -L;
 		mult_trans_pdf = 1.0f;
 		pre_position = info.position;
+		vertex_position = info.position;
+		vertex_normal = info.Ns;
 		ray = Ray::SpawnRay(info.position, L, info.Ng);
+		rayMask = RayVisibility::IndirectVisibility;
+		trace.next = trace.count;
 
 		// Russian roulette
 		if (bounce > 3 && history.MaxComponentValue() < 0.3f) {
 			auto continueProperbility = std::max(0.05f, 1.0f - history.MaxComponentValue());
 
-			if (sampler->Get1() < continueProperbility) {
+			if (sampler.Get1() < continueProperbility) {
 				break;
 			}
 
@@ -206,27 +233,419 @@ Spectrum VolumetricPathTracing::SolvingIntegrator(Ray& ray, IntersectionInfo& in
 	return radiance;
 }
 
-void VolumetricPathTracing::RenderImage(std::shared_ptr<PostProcessing> post, RGBSpectrum* image) {
-	omp_set_num_threads(32);
-#pragma omp parallel for
-	for (int j = 0; j < height; j++) {
-		for (int i = 0; i < width; i++) {
-			sampler->SetPixel(i, j);
+void VolumetricPathTracing::RenderImage(int spp, std::shared_ptr<Film> film) {
+	// Every packet lane of every thread draws from its own copy of the sampler
+	std::vector<std::vector<std::shared_ptr<Sampler>>> samplers(scheduler->GetThreads());
+	for (auto& laneSamplers : samplers) {
+		for (int l = 0; l < PacketSize; l++) {
+			laneSamplers.push_back(sampler->Clone());
+		}
+	}
+
+	// Noisy tiles take the samples of the converged ones
+	scheduler->SetImageSize(width, height);
+	film->AllocateSamples(scheduler->GetTiles(), spp, noiseThreshold, minSamples);
+
+	scheduler->Run(width, height, [&](const Tile& tile, int thread) {
+		auto& laneSamplers = samplers[thread];
+		int tileWidth = tile.x1 - tile.x0;
+		int count = tileWidth * (tile.y1 - tile.y0);
+		// Every pixel of a tile gets the same share of the pass
+		int tileSpp = film->GetPassSamples(tile.x0, tile.y0);
+
+		std::vector<Ray> rays;
+		rays.reserve(PacketSize);
+		for (int first = 0; first < count; first += PacketSize) {
+			int lanes = std::min<int>(PacketSize, count - first);
+
+			// All samples of a pixel group in a row while its film entries are in cache
+			for (int s = 0; s < tileSpp; s++) {
+				RTCRayHit8 packet;
+				alignas(32) int valid[PacketSize] = {};
+				IntersectionInfo infos[PacketSize];
+
+				// Camera rays are coherent, the first bounce is traced as one packet
+				rays.clear();
+				for (int l = 0; l < lanes; l++) {
+					int i = tile.x0 + (first + l) % tileWidth;
+					int j = tile.y0 + (first + l) / tileWidth;
+					auto& laneSampler = laneSamplers[l];
+					// Pixels take different numbers of samples, so each one continues its own sequence.
+					// Within the pass a lane steps through consecutive indices, which samplers update incrementally
+					if (s == 0) {
+						laneSampler->SetSampleIndex(film->GetSampleCount(i, j));
+						laneSampler->SetPixel(i, j);
+					}
+					else {
+						laneSampler->NextSample();
+					}
+
+					Point2f jitter = filter->FilterPoint2f(laneSampler->Get2());
+					float pixelX = ((float)i + 0.5f + jitter.x) / width;
+					float pixelY = ((float)j + 0.5f + jitter.y) / height;
+
+					rays.push_back(scene->GetCamera()->GenerateRay(*laneSampler, pixelX, pixelY));
+					SetRayHit8(packet, l, rays[l].GetOrg(), rays[l].GetDir(), 0.0f, Infinity, RayVisibility::CameraVisibility);
+					valid[l] = -1;
+				}
+				scene->TracePacket(packet, valid, infos);
+
+				for (int l = 0; l < lanes; l++) {
+					int i = tile.x0 + (first + l) % tileWidth;
+					int j = tile.y0 + (first + l) / tileWidth;
+					Spectrum radiance = SolvingPath(rays[l], infos[l], *laneSamplers[l], true);
+
+					if (radiance.HasNaNs()) {
+						assert(0);
+					}
+
+					film->AddSample(i, j, radiance.ToRGBSpectrum());
+				}
+			}
+		}
+	});
+}
+
+void WavefrontPathTracing::PathStates::Resize(int n, std::shared_ptr<Sampler> prototype) {
+	while (samplers.size() < n) {
+		samplers.push_back(prototype->Clone());
+	}
+
+	rayhits.resize(n);
+	radiance.resize(n);
+	history.resize(n);
+	V.resize(n);
+	L.resize(n);
+	pre_position.resize(n);
+	vertex_position.resize(n);
+	vertex_normal.resize(n);
+	bp_pdf.resize(n);
+	mult_trans_pdf.resize(n);
+	bounce.resize(n);
+	depth.resize(n);
+}
+
+void WavefrontPathTracing::StartPath(PathStates& paths, int index, const Ray& ray) {
+	paths.rayhits[index] = MakeRayHit(ray.GetOrg(), ray.GetDir(), 0.0f, Infinity, RayVisibility::CameraVisibility);
+	paths.radiance[index] = Spectrum(0.0f);
+	paths.history[index] = Spectrum(1.0f);
+	paths.V[index] = -ray.GetDir();
+	paths.L[index] = ray.GetDir();
+	paths.pre_position[index] = ray.GetOrg();
+	paths.vertex_position[index] = ray.GetOrg();
+	paths.vertex_normal[index] = Vector3f(0.0f);
+	paths.bp_pdf[index] = 0.0f;
+	paths.mult_trans_pdf[index] = 1.0f;
+	paths.bounce[index] = 0;
+	paths.depth[index] = 0;
+	paths.active.push_back(index);
+}
+
+void WavefrontPathTracing::TracePaths(PathStates& paths) {
+	// Only the camera rays of the first wave are coherent
+	bool coherent = true;
+	while (!paths.active.empty()) {
+		int count = paths.active.size();
+
+		// Extension rays of every live path in one stream query
+		paths.stream.resize(count);
+		paths.infos.resize(count);
+		for (int k = 0; k < count; k++) {
+			paths.stream[k] = paths.rayhits[paths.active[k]];
+		}
+		scene->TraceRays(paths.stream.data(), paths.infos.data(), count, coherent);
+		coherent = false;
+
+		// Group the hits by material, so consecutive shading calls run the same code
+		paths.keys.resize(count);
+		paths.order.resize(count);
+		for (int k = 0; k < count; k++) {
+			paths.keys[k] = paths.infos[k].materialID;
+			paths.order[k] = k;
+		}
+		std::stable_sort(paths.order.begin(), paths.order.end(), [&paths](int a, int b) {
+			return paths.keys[a] < paths.keys[b];
+		});
+
+		paths.next.clear();
+		paths.shadowRays.clear();
+		paths.shadowRadiance.clear();
+		paths.shadowPaths.clear();
+		for (int k : paths.order) {
+			int index = paths.active[k];
+			if (ShadePath(paths, index, paths.infos[k])) {
+				paths.next.push_back(index);
+			}
+		}
+
+		// Shadow rays of the whole bounce in one stream query, occluded rays come back with tfar = -inf
+		if (!paths.shadowRays.empty()) {
+			scene->OccludedRays(paths.shadowRays.data(), paths.shadowRays.size());
+			for (int k = 0; k < paths.shadowRays.size(); k++) {
+				if (paths.shadowRays[k].tfar >= 0.0f) {
+					paths.radiance[paths.shadowPaths[k]] += paths.shadowRadiance[k];
+				}
+			}
+		}
+
+		paths.active.swap(paths.next);
+	}
+}
+
+bool WavefrontPathTracing::ShadePath(PathStates& paths, int index, IntersectionInfo& info) {
+	Sampler& sampler = *paths.samplers[index];
+	Spectrum& radiance = paths.radiance[index];
+	Spectrum& history = paths.history[index];
+	Vector3f& V = paths.V[index];
+	Vector3f& L = paths.L[index];
+	Point3f& pre_position = paths.pre_position[index];
+	float& bp_pdf = paths.bp_pdf[index];
+	float& mult_trans_pdf = paths.mult_trans_pdf[index];
+	int& bounce = paths.bounce[index];
+	sampler.StartBounce(paths.depth[index]++);
+
+	Medium* medium = scene->GetMedium(info.GetMediumID(HitLight(*scene, info) ? true : info.frontFace));
+	bool scattered = false;
+	float trans_pdf = 0.0f;
+	float actual_distance = 0.0f;
+	Spectrum transmittance(0.0f);
+
+	if (medium != NULL) {
+		// Sample medium distance
+		transmittance = medium->SampleDistance(history, info.t, actual_distance, trans_pdf, scattered, sampler);
+
+		if (std::isnan(trans_pdf) || trans_pdf == 0.0f) {
+			return false;
+		}
+
+		history *= (transmittance / trans_pdf);
+		mult_trans_pdf *= trans_pdf;
+
+		if (scattered) {
+			UpdateMediumInfo(info, actual_distance, pre_position, L);
+
+			// Sample light, shadow rays inside media go through the transmittance loop
+			Vector3f lightL;
+			float light_pdf = 0.0f;
+			float phase_pdf = 0.0f;
+			float mult_trans_pdf_nee = 1.0f;
+			Spectrum light_radiance = scene->SampleLightEnvironment(history, lightL, light_pdf, mult_trans_pdf_nee, info, sampler);
+			Spectrum attenuation = medium->GetPhaseFunction()->Evaluate(V, lightL, phase_pdf, info);
+			phase_pdf *= mult_trans_pdf_nee;
+
+			if (!(std::isnan(phase_pdf) || std::isnan(light_pdf) || phase_pdf == 0.0f || light_pdf == 0.0f)) {
+				float misWeight = PowerHeuristic(light_pdf, phase_pdf, 2);
+
+				radiance += misWeight * history * attenuation * light_radiance / light_pdf;
+			}
+
+			// Sample phase
+			attenuation = medium->GetPhaseFunction()->Sample(V, L, phase_pdf, info, sampler);
+
+			if (std::isnan(phase_pdf) || phase_pdf == 0.0f) {
+				return false;
+			}
+
+			bp_pdf = phase_pdf;
+			history *= (attenuation / phase_pdf);
+		}
+	}
+
+	if (!scattered) {
+		if (HitLight(*scene, info)) {// Hit light
+			float misWeight = 1.0f;
+			float light_pdf = 0.0f;
+			Spectrum light_radiance = scene->EvaluateLight(info.geomID, L, light_pdf, info, paths.vertex_position[index], paths.vertex_normal[index]);
+			bp_pdf *= mult_trans_pdf;
+
+			if (bounce != 0) {
+				if (std::isnan(light_pdf) || light_pdf == 0.0f) {
+					return false;
+				}
+
+				misWeight = PowerHeuristic(bp_pdf, light_pdf, 2);
+			}
+
+			radiance += misWeight * history * light_radiance;
+
+			return false;
+		}
+		else if (HitNothing(info)) {// Hit nothing
+			float misWeight = 1.0f;
+			float light_pdf = 0.0f;
+			Spectrum back_radiance = scene->EvaluateEnvironment(L, light_pdf);
+			bp_pdf *= mult_trans_pdf;
+
+			if (bounce != 0) {
+				if (std::isnan(light_pdf) || light_pdf == 0.0f) {
+					return false;
+				}
+
+				misWeight = PowerHeuristic(bp_pdf, light_pdf, 2);
+			}
+
+			radiance += misWeight * history * back_radiance;
+
+			return false;
+		}
+		else if (HitMediumBoundary(*scene, info)) {// Hit medium boundary, does not count as a bounce
+			V = -L;
+			pre_position = info.position;
+			Ray ray = Ray::SpawnRay(pre_position, L, info.Ng);
+			// The ray keeps its type through the boundary
+			paths.rayhits[index] = MakeRayHit(ray.GetOrg(), ray.GetDir(), 0.0f, Infinity, paths.rayhits[index].ray.mask);
+
+			return true;
+		}
+		else {
+			Material* material = scene->GetMaterial(info.materialID);
+
+			// Sample light
+			float light_pdf = 0.0f, bsdf_pdf = 0.0f;
+			Vector3f lightL;
+			if (scene->HasMedia()) {
+				float mult_trans_pdf_nee = 1.0f;
+				Spectrum light_radiance = scene->SampleLightEnvironment(history, lightL, light_pdf, mult_trans_pdf_nee, info, sampler);
+				Spectrum bsdf = material->Evaluate(V, lightL, bsdf_pdf, info);
+				bsdf_pdf *= mult_trans_pdf_nee;
+				float costheta = std::max(glm::dot(info.Ns, lightL), 0.0f);
+
+				if (!(std::isnan(bsdf_pdf) || std::isnan(light_pdf) || bsdf_pdf == 0.0f || light_pdf == 0.0f)) {
+					float misWeight = PowerHeuristic(light_pdf, bsdf_pdf, 2);
+
+					radiance += misWeight * history * bsdf * costheta * light_radiance / light_pdf;
+				}
+			}
+			else {
+				// Visibility is resolved later with the shadow ray stream of this bounce
+				float dist = 0.0f;
+				Spectrum light_radiance = scene->SampleLight(lightL, light_pdf, dist, info, sampler);
+				Spectrum bsdf = material->Evaluate(V, lightL, bsdf_pdf, info);
+				float costheta = std::max(glm::dot(info.Ns, lightL), 0.0f);
+
+				if (!(std::isnan(bsdf_pdf) || std::isnan(light_pdf) || bsdf_pdf == 0.0f || light_pdf == 0.0f)) {
+					float misWeight = PowerHeuristic(light_pdf, bsdf_pdf, 2);
 
-			Point2f jitter = filter->FilterPoint2f(sampler->Get2());
-			float pixelX = ((float)i + 0.5f + jitter.x) / width;
-			float pixelY = ((float)j + 0.5f + jitter.y) / height;
+					paths.shadowRays.push_back(MakeRay(info.position, lightL, Epsilon, dist - Epsilon, RayVisibility::ShadowVisibility));
+					paths.shadowRadiance.push_back(misWeight * history * bsdf * costheta * light_radiance / light_pdf);
+					paths.shadowPaths.push_back(index);
+				}
+			}
 
-			IntersectionInfo info;
-			Ray ray = scene->GetCamera()->GenerateRay(sampler, pixelX, pixelY);
-			Spectrum radiance = SolvingIntegrator(ray, info);
+			// Sample surface
+			Spectrum bsdf = material->Sample(V, L, bsdf_pdf, info, sampler);
+			bp_pdf = bsdf_pdf;
+			float costheta = std::abs(glm::dot(info.Ns, L));
 
-			if (radiance.HasNaNs()) {
-				assert(0);
+			if (std::isnan(bsdf_pdf) || bsdf_pdf == 0.0f) {
+				return false;
 			}
 
-			image[j * width + i] = post->GetScreenColor(radiance.ToRGBSpectrum());
+			history *= (bsdf * costheta / bsdf_pdf);
+		}
+	}
+
+	// Update information
+	V = -L;
+	mult_trans_pdf = 1.0f;
+	pre_position = info.position;
+	paths.vertex_position[index] = info.position;
+	paths.vertex_normal[index] = info.Ns;
+	Ray ray = Ray::SpawnRay(info.position, L, info.Ng);
+	paths.rayhits[index] = MakeRayHit(ray.GetOrg(), ray.GetDir(), 0.0f, Infinity, RayVisibility::IndirectVisibility);
+
+	// Russian roulette
+	if (bounce > 3 && history.MaxComponentValue() < 0.3f) {
+		auto continueProperbility = std::max(0.05f, 1.0f - history.MaxComponentValue());
+
+		if (sampler.Get1() < continueProperbility) {
+			return false;
 		}
+
+		history /= (1.0f - continueProperbility);
 	}
-	sampler->NextSample();
+
+	if (history.HasNaNs()) {
+		return false;
+	}
+
+	bounce++;
+
+	return bounce < maxBounce;
+}
+
+Spectrum WavefrontPathTracing::SolvingIntegrator(Ray& ray, IntersectionInfo& info, Sampler& sampler) {
+	// A wavefront holding a single path
+	PathStates paths;
+	// Non-owning handle, the caller keeps its sampler alive for the call
+	paths.samplers.push_back(std::shared_ptr<Sampler>(std::shared_ptr<Sampler>(), &sampler));
+	paths.Resize(1, NULL);
+	StartPath(paths, 0, ray);
+	TracePaths(paths);
+
+	return paths.radiance[0];
 }
+
+void WavefrontPathTracing::RenderImage(int spp, std::shared_ptr<Film> film) {
+	int tileSize = scheduler->GetTileSize();
+	if (threadPaths.size() != scheduler->GetThreads()) {
+		threadPaths.clear();
+		threadPaths.resize(scheduler->GetThreads());
+	}
+
+	// Every path slot keeps its own sampler across frames
+	for (auto& paths : threadPaths) {
+		paths.Resize(tileSize * tileSize, sampler);
+	}
+
+	// Noisy tiles take the samples of the converged ones
+	scheduler->SetImageSize(width, height);
+	film->AllocateSamples(scheduler->GetTiles(), spp, noiseThreshold, minSamples);
+
+	scheduler->Run(width, height, [&](const Tile& tile, int thread) {
+		PathStates& paths = threadPaths[thread];
+		int tileWidth = tile.x1 - tile.x0;
+		int count = tileWidth * (tile.y1 - tile.y0);
+		// Every pixel of a tile gets the same share of the pass
+		int tileSpp = film->GetPassSamples(tile.x0, tile.y0);
+
+		for (int s = 0; s < tileSpp; s++) {
+			// Camera rays of the whole tile
+			paths.active.clear();
+			for (int k = 0; k < count; k++) {
+				int i = tile.x0 + k % tileWidth;
+				int j = tile.y0 + k / tileWidth;
+				auto& pathSampler = paths.samplers[k];
+				// Pixels take different numbers of samples, so each one continues its own sequence.
+				// Within the pass a path slot steps through consecutive indices, which samplers update incrementally
+				if (s == 0) {
+					pathSampler->SetSampleIndex(film->GetSampleCount(i, j));
+					pathSampler->SetPixel(i, j);
+				}
+				else {
+					pathSampler->NextSample();
+				}
+
+				Point2f jitter = filter->FilterPoint2f(pathSampler->Get2());
+				float pixelX = ((float)i + 0.5f + jitter.x) / width;
+				float pixelY = ((float)j + 0.5f + jitter.y) / height;
+
+				Ray ray = scene->GetCamera()->GenerateRay(*pathSampler, pixelX, pixelY);
+				StartPath(paths, k, ray);
+			}
+
+			TracePaths(paths);
+
+			for (int k = 0; k < count; k++) {
+				int i = tile.x0 + k % tileWidth;
+				int j = tile.y0 + k / tileWidth;
+
+				if (paths.radiance[k].HasNaNs()) {
+					assert(0);
+				}
+
+				film->AddSample(i, j, paths.radiance[k].ToRGBSpectrum());
+			}
+		}
+	});
+}
\ No newline at end of file
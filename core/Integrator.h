@@ -7,9 +7,12 @@
 #include "Medium.h"
 #include "Spectrum.h"
 #include "PostProcessing.h"
+#include "Film.h"
+#include "Scheduler.h"
 
 enum IntegratorType {
-	VolumetricPathTracingIntegrator
+	VolumetricPathTracingIntegrator,
+	WavefrontPathTracingIntegrator
 };
 
 struct IntegratorParams {
@@ -27,17 +30,49 @@ class Integrator {
 
 public:
 	Integrator(IntegratorType type, std::shared_ptr<Scene> s, std::shared_ptr<Sampler> sa, std::shared_ptr<Filter> f, int w, int h) :
-		m_type(type), scene(s), sampler(sa), filter(f), width(w), height(h) {}
+		m_type(type), scene(s), sampler(sa), filter(f), width(w), height(h), scheduler(std::make_shared<TileScheduler>()) {}
 
 	inline IntegratorType GetType() const {
 		return m_type;
 	}
 
+	inline std::shared_ptr<TileScheduler> GetScheduler() const {
+		return scheduler;
+	}
+
+	inline void SetScheduler(std::shared_ptr<TileScheduler> s) {
+		scheduler = s;
+	}
+
+	inline std::shared_ptr<Sampler> GetSampler() const {
+		return sampler;
+	}
+
+	// Call before the first RenderImage, integrators keep clones of the sampler
+	inline void SetSampler(std::shared_ptr<Sampler> s) {
+		sampler = s;
+	}
+
+	inline float GetNoiseThreshold() const {
+		return noiseThreshold;
+	}
+
+	inline int GetMinSamples() const {
+		return minSamples;
+	}
+
+	// threshold = 0 disables adaptive sampling, every pixel gets every sample of a pass
+	inline void SetAdaptiveSampling(float threshold, int minSpp = 16) {
+		noiseThreshold = threshold;
+		minSamples = minSpp;
+	}
+
 	float PowerHeuristic(float pdf1, float pdf2, int beta);
 
-	virtual Spectrum SolvingIntegrator(Ray& ray, IntersectionInfo& info) = 0;
+	virtual Spectrum SolvingIntegrator(Ray& ray, IntersectionInfo& info, Sampler& sampler) = 0;
 
-	virtual void RenderImage(std::shared_ptr<PostProcessing> post, RGBSpectrum* image) = 0;
+	// Accumulates spp samples of every pixel into the film
+	virtual void RenderImage(int spp, std::shared_ptr<Film> film) = 0;
 
 	static std::shared_ptr<Integrator> Create(const IntegratorParams& params);
 
@@ -47,6 +82,9 @@ protected:
 	std::shared_ptr<Scene> scene;
 	std::shared_ptr<Filter> filter;
 	std::shared_ptr<Sampler> sampler;
+	std::shared_ptr<TileScheduler> scheduler;
+	float noiseThreshold = 0.0f;
+	int minSamples = 16;
 };
 
 class VolumetricPathTracing : public Integrator {
@@ -54,10 +92,66 @@ public:
 	VolumetricPathTracing(std::shared_ptr<Scene> s, std::shared_ptr<Sampler> sa, std::shared_ptr<Filter> f, int w, int h, int bounce) :
 		Integrator(IntegratorType::VolumetricPathTracingIntegrator, s, sa, f, w, h), maxBounce(bounce) {}
 
-	virtual Spectrum SolvingIntegrator(Ray& ray, IntersectionInfo& info) override;
+	virtual Spectrum SolvingIntegrator(Ray& ray, IntersectionInfo& info, Sampler& sampler) override;
+
+	virtual void RenderImage(int spp, std::shared_ptr<Film> film) override;
+
+private:
+	// traced = true when info already holds the hit of the camera ray
+	Spectrum SolvingPath(Ray& ray, IntersectionInfo& info, Sampler& sampler, bool traced);
+
+private:
+	int maxBounce;
+};
+
+// Breadth-first variant of VolumetricPathTracing, every tile is traced as one wavefront of paths
+class WavefrontPathTracing : public Integrator {
+public:
+	WavefrontPathTracing(std::shared_ptr<Scene> s, std::shared_ptr<Sampler> sa, std::shared_ptr<Filter> f, int w, int h, int bounce) :
+		Integrator(IntegratorType::WavefrontPathTracingIntegrator, s, sa, f, w, h), maxBounce(bounce) {}
+
+	virtual Spectrum SolvingIntegrator(Ray& ray, IntersectionInfo& info, Sampler& sampler) override;
+
+	virtual void RenderImage(int spp, std::shared_ptr<Film> film) override;
+
+private:
+	// Structure of arrays holding the state of every path in a wavefront
+	struct PathStates {
+		std::vector<std::shared_ptr<Sampler>> samplers;
+		std::vector<RTCRayHit> rayhits;
+		std::vector<Spectrum> radiance;
+		std::vector<Spectrum> history;
+		std::vector<Vector3f> V;
+		std::vector<Vector3f> L;
+		std::vector<Point3f> pre_position;
+		std::vector<Point3f> vertex_position;// last scattering vertex
+		std::vector<Vector3f> vertex_normal;
+		std::vector<float> bp_pdf;
+		std::vector<float> mult_trans_pdf;
+		std::vector<int> bounce;
+		std::vector<int> depth;
+
+		// Queues of the current bounce
+		std::vector<int> active;
+		std::vector<int> next;
+		std::vector<int> order;
+		std::vector<int> keys;
+		std::vector<RTCRayHit> stream;
+		std::vector<IntersectionInfo> infos;
+		std::vector<RTCRay> shadowRays;
+		std::vector<Spectrum> shadowRadiance;
+		std::vector<int> shadowPaths;
+
+		void Resize(int n, std::shared_ptr<Sampler> prototype);
+	};
+
+	void StartPath(PathStates& paths, int index, const Ray& ray);
+
+	void TracePaths(PathStates& paths);
 
-	virtual void RenderImage(std::shared_ptr<PostProcessing> post, RGBSpectrum* image) override;
+	bool ShadePath(PathStates& paths, int index, IntersectionInfo& info);
 
 private:
 	int maxBounce;
+	std::vector<PathStates> threadPaths;
 };
\ No newline at end of file
@@ -1,5 +1,107 @@
 #include "Light.h"
 
+// cos(max(0, a - b)) and sin(max(0, a - b)) from the sines and cosines of a and b
+static float CosSubClamped(float sin_a, float cos_a, float sin_b, float cos_b) {
+	return cos_a > cos_b ? 1.0f : cos_a * cos_b + sin_a * sin_b;
+}
+
+static float SinSubClamped(float sin_a, float cos_a, float sin_b, float cos_b) {
+	return cos_a > cos_b ? 0.0f : sin_a * cos_b - cos_a * sin_b;
+}
+
+static float SinFromCos(float cos_theta) {
+	return std::sqrt(std::max(0.0f, 1.0f - cos_theta * cos_theta));
+}
+
+float LightBounds::Importance(const Point3f& p, const Vector3f& n) const {
+	// Distance to the center, clamped so points inside the bounds do not blow up
+	Point3f pc = (pMin + pMax) * 0.5f;
+	float d2 = glm::dot(p - pc, p - pc);
+	d2 = std::max(d2, glm::length(pMax - pMin) * 0.5f);
+
+	Vector3f wi = glm::normalize(p - pc);
+	if (d2 == 0.0f || std::isnan(wi.x)) {
+		wi = w;
+	}
+	float cos_theta_w = glm::dot(w, wi);
+	if (twoSided) {
+		cos_theta_w = std::abs(cos_theta_w);
+	}
+	float sin_theta_w = SinFromCos(cos_theta_w);
+
+	// Directions to p from anywhere in the bounds lie in a cone of half angle theta_b
+	float radius_sq = glm::dot(pMax - pc, pMax - pc);
+	float dist_sq = glm::dot(p - pc, p - pc);
+	float cos_theta_b = dist_sq < radius_sq ? -1.0f : std::sqrt(std::max(0.0f, 1.0f - radius_sq / dist_sq));
+	float sin_theta_b = SinFromCos(cos_theta_b);
+
+	// Smallest angle between the emission and p: theta' = max(0, theta_w - theta_o - theta_b)
+	float sin_theta_o = SinFromCos(cos_theta_o);
+	float cos_theta_x = CosSubClamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+	float sin_theta_x = SinSubClamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+	float cos_theta_p = CosSubClamped(sin_theta_x, cos_theta_x, sin_theta_b, cos_theta_b);
+	if (cos_theta_p <= cos_theta_e) {
+		return 0.0f;
+	}
+
+	float importance = phi * cos_theta_p / d2;
+
+	// Incident cosine at the shading point, media have no normal
+	if (n != Vector3f(0.0f)) {
+		float cos_theta_i = std::abs(glm::dot(wi, n));
+		float sin_theta_i = SinFromCos(cos_theta_i);
+		importance *= CosSubClamped(sin_theta_i, cos_theta_i, sin_theta_b, cos_theta_b);
+	}
+
+	return std::max(importance, 0.0f);
+}
+
+LightBounds LightBounds::Union(const LightBounds& a, const LightBounds& b) {
+	if (a.phi == 0.0f) {
+		return b;
+	}
+	if (b.phi == 0.0f) {
+		return a;
+	}
+
+	LightBounds bounds;
+	bounds.pMin = glm::min(a.pMin, b.pMin);
+	bounds.pMax = glm::max(a.pMax, b.pMax);
+	bounds.phi = a.phi + b.phi;
+	bounds.cos_theta_e = std::min(a.cos_theta_e, b.cos_theta_e);
+	bounds.twoSided = a.twoSided || b.twoSided;
+
+	// Smallest cone holding both normal cones
+	float theta_a = std::acos(glm::clamp(a.cos_theta_o, -1.0f, 1.0f));
+	float theta_b = std::acos(glm::clamp(b.cos_theta_o, -1.0f, 1.0f));
+	float theta_d = std::acos(glm::clamp(glm::dot(a.w, b.w), -1.0f, 1.0f));
+	if (std::min(theta_d + theta_b, PI) <= theta_a) {
+		bounds.w = a.w;
+		bounds.cos_theta_o = a.cos_theta_o;
+	}
+	else if (std::min(theta_d + theta_a, PI) <= theta_b) {
+		bounds.w = b.w;
+		bounds.cos_theta_o = b.cos_theta_o;
+	}
+	else {
+		float theta_o = (theta_a + theta_d + theta_b) * 0.5f;
+		Vector3f axis = glm::cross(a.w, b.w);
+		if (theta_o >= PI || glm::dot(axis, axis) == 0.0f) {
+			bounds.w = a.w;
+			bounds.cos_theta_o = -1.0f;
+		}
+		else {
+			// Rotate a.w towards b.w by theta_o - theta_a
+			float theta_r = theta_o - theta_a;
+			axis = glm::normalize(axis);
+			bounds.w = glm::normalize(a.w * std::cos(theta_r) + glm::cross(axis, a.w) * std::sin(theta_r) + axis * glm::dot(axis, a.w) * (1.0f - std::cos(theta_r)));
+			bounds.cos_theta_o = std::cos(theta_o);
+		}
+	}
+
+	return bounds;
+}
+
 Light::~Light() {
 	if (shape != NULL) {
 		delete shape;
@@ -19,6 +121,10 @@ Spectrum Light::Evaluate(const Vector3f& L, float& pdf, const IntersectionInfo&
 	return Spectrum(0.0f);
 }
 
+LightBounds Light::GetBounds() const {
+	return LightBounds();
+}
+
 
 Spectrum QuadArea::Evaluate(const Vector3f& L, float& pdf, const IntersectionInfo& info) {
 	Quad* quad = (Quad*)shape;
@@ -42,10 +148,10 @@ Spectrum QuadArea::Evaluate(const Vector3f& L, float& pdf, const IntersectionInf
 	return shape->GetMaterial()->Emit();// info record a point on a light source
 }
 
-Spectrum QuadArea::Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum QuadArea::Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler) {
 	Quad* quad = (Quad*)shape;
 	Vector3f Nl = glm::cross(quad->u, quad->v);
-	Point3f pos = quad->position + quad->u * sampler->Get1() + quad->v * sampler->Get1();
+	Point3f pos = quad->position + quad->u * sampler.Get1() + quad->v * sampler.Get1();
 	L = pos - info.position;
 	float dist_sq = glm::dot(L, L);
 	float distance = std::sqrt(dist_sq);
@@ -67,6 +173,23 @@ Spectrum QuadArea::Sample(Vector3f& L, float& pdf, float& dist, const Intersecti
 	return shape->GetMaterial()->Emit();// info record a point on a common shape
 }
 
+LightBounds QuadArea::GetBounds() const {
+	Quad* quad = (Quad*)shape;
+	Point3f p[4] = { quad->position, quad->position + quad->u, quad->position + quad->u + quad->v, quad->position + quad->v };
+	Vector3f Nl = glm::cross(quad->u, quad->v);
+
+	// Emits on the side of u x v
+	LightBounds bounds;
+	for (int i = 0; i < 4; i++) {
+		bounds.pMin = glm::min(bounds.pMin, p[i]);
+		bounds.pMax = glm::max(bounds.pMax, p[i]);
+	}
+	bounds.w = glm::normalize(Nl);
+	bounds.phi = Luminance(shape->GetMaterial()->Emit()) * glm::length(Nl) * PI;
+
+	return bounds;
+}
+
 Spectrum SphereArea::Evaluate(const Vector3f& L, float& pdf, const IntersectionInfo& info) {
 	Sphere* sphere = (Sphere*)shape;
 	Vector3f dir = sphere->center - info.position;
@@ -78,7 +201,7 @@ Spectrum SphereArea::Evaluate(const Vector3f& L, float& pdf, const IntersectionI
 	return shape->GetMaterial()->Emit();
 }
 
-Spectrum SphereArea::Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum SphereArea::Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler) {
 	Sphere* sphere = (Sphere*)shape;
 	Vector3f dir = sphere->center - info.position;
 	float dist_sq = glm::dot(dir, dir);
@@ -89,7 +212,7 @@ Spectrum SphereArea::Sample(Vector3f& L, float& pdf, float& dist, const Intersec
 	float sin_theta = sphere->radius * inv_dist;
 	if (sin_theta < 1.0f) {
 		float cos_theta = std::sqrt(1.0f - sin_theta * sin_theta);
-		Vector3f local_L = UniformSampleCone(sampler->Get2(), cos_theta);
+		Vector3f local_L = UniformSampleCone(sampler.Get2(), cos_theta);
 		float cos_i = local_L.z;
 		L = ToWorld(local_L, dir);
 		pdf = UniformPdfCone(cos_theta);
@@ -103,6 +226,19 @@ Spectrum SphereArea::Sample(Vector3f& L, float& pdf, float& dist, const Intersec
 	return Spectrum(0.0f);
 }
 
+LightBounds SphereArea::GetBounds() const {
+	Sphere* sphere = (Sphere*)shape;
+
+	// Normals in every direction
+	LightBounds bounds;
+	bounds.pMin = sphere->center - Vector3f(sphere->radius);
+	bounds.pMax = sphere->center + Vector3f(sphere->radius);
+	bounds.cos_theta_o = -1.0f;
+	bounds.phi = Luminance(shape->GetMaterial()->Emit()) * 4.0f * PI * sphere->radius * sphere->radius * PI;
+
+	return bounds;
+}
+
 InfiniteArea::InfiniteArea(std::shared_ptr<Hdr> h, float sca) : Light(LightType::InfiniteAreaLight, NULL), hdr(h), scale(sca) {
 	int mWidth = hdr->nx;
 	int mHeight = hdr->ny;
@@ -143,10 +279,10 @@ Spectrum InfiniteArea::EvaluateEnvironment(const Vector3f& L, float& pdf) {
 	return radiance * scale;
 }
 
-Spectrum InfiniteArea::Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum InfiniteArea::Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler) {
 	dist = Infinity;
 
-	auto [col, row] = table.Sample(sampler->Get2(), sampler->Get2());
+	auto [col, row] = table.Sample(sampler.Get2(), sampler.Get2());
 
 	int mWidth = hdr->nx;
 	int mHeight = hdr->ny;
@@ -206,17 +342,17 @@ Spectrum TriangleMeshArea::Evaluate(const Vector3f& L, float& pdf, const Interse
 	return shape->GetMaterial()->Emit();
 }
 
-Spectrum TriangleMeshArea::Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum TriangleMeshArea::Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler) {
 	TriangleMesh* mesh = (TriangleMesh*)shape;
-	int id = table.Sample(sampler->Get2());
+	int id = table.Sample(sampler.Get2());
 	Point3u index = mesh->GetIndices(id);
 	Point3f v0 = mesh->GetVertex(index[0]);
 	Point3f v1 = mesh->GetVertex(index[1]);
 	Point3f v2 = mesh->GetVertex(index[2]);
 
-	float a = std::sqrt(sampler->Get1());
+	float a = std::sqrt(sampler.Get1());
 	float b1 = 1.0f - a;
-	float b2 = a * sampler->Get1();
+	float b2 = a * sampler.Get1();
 
 	Point3f p = (1.0f - b1 - b2) * v0 + v1 * b1 + v2 * b2;
 	L = p - info.position;
@@ -240,6 +376,43 @@ Spectrum TriangleMeshArea::Sample(Vector3f& L, float& pdf, float& dist, const In
 	return shape->GetMaterial()->Emit();
 }
 
+LightBounds TriangleMeshArea::GetBounds() const {
+	TriangleMesh* mesh = (TriangleMesh*)shape;
+
+	LightBounds bounds;
+	Vector3f axis(0.0f);
+	for (uint32_t i = 0; i < mesh->Faces(); i++) {
+		Point3u index = mesh->GetIndices(i);
+		for (int k = 0; k < 3; k++) {
+			bounds.pMin = glm::min(bounds.pMin, mesh->GetVertex(index[k]));
+			bounds.pMax = glm::max(bounds.pMax, mesh->GetVertex(index[k]));
+		}
+		if (areas[i] > 0.0f) {
+			axis += areas[i] * mesh->GetGeometryNormal(i);
+		}
+	}
+
+	// Normal cone around the area weighted normal, hits on the back of a mesh light are lit too
+	bounds.twoSided = true;
+	bounds.cos_theta_o = -1.0f;
+	if (glm::dot(axis, axis) > 0.0f) {
+		bounds.w = glm::normalize(axis);
+		bounds.cos_theta_o = 1.0f;
+		for (uint32_t i = 0; i < mesh->Faces(); i++) {
+			if (areas[i] > 0.0f) {
+				bounds.cos_theta_o = std::min(bounds.cos_theta_o, glm::dot(bounds.w, mesh->GetGeometryNormal(i)));
+			}
+		}
+	}
+	// Both sides emit, so the power is twice that of a one-sided emitter of the same area
+	bounds.phi = Luminance(shape->GetMaterial()->Emit()) * table.Sum() * PI;
+	if (bounds.twoSided) {
+		bounds.phi *= 2.0f;
+	}
+
+	return bounds;
+}
+
 std::shared_ptr<Light> Light::Create(const LightParams& params) {
 	if (params.type == LightType::QuadAreaLight) {
 		return std::make_shared<QuadArea>(params.shape);
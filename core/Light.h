@@ -12,6 +12,22 @@ enum LightType {
 	TriangleMeshAreaLight
 };
 
+// Where a light or a group of lights emits from and in which directions, used to rank lights per shading point
+struct LightBounds {
+	Point3f pMin = Point3f(Infinity);
+	Point3f pMax = Point3f(-Infinity);
+	Vector3f w = Vector3f(0.0f, 0.0f, 1.0f);// axis of the normal cone
+	float phi = 0.0f;// emitted power, 0 for lights that are not bounded
+	float cos_theta_o = 1.0f;// spread of the surface normals around w
+	float cos_theta_e = 0.0f;// emission past the normals, cos(pi / 2) for diffuse emitters
+	bool twoSided = false;
+
+	// Conservative estimate of the light reaching p, n is the shading normal or zero inside media
+	float Importance(const Point3f& p, const Vector3f& n) const;
+
+	static LightBounds Union(const LightBounds& a, const LightBounds& b);
+};
+
 struct LightParams {
 	LightType type;
 	Shape* shape;
@@ -41,7 +57,10 @@ public:
 
 	virtual Spectrum Evaluate(const Vector3f& L, float& pdf, const IntersectionInfo& info);
 
-	virtual Spectrum Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) = 0;
+	virtual Spectrum Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler) = 0;
+
+	// Lights at infinity have no bounds and are sampled apart from the light BVH
+	virtual LightBounds GetBounds() const;
 
 	static std::shared_ptr<Light> Create(const LightParams& params);
 
@@ -56,7 +75,9 @@ public:
 
 	virtual Spectrum Evaluate(const Vector3f& L, float& pdf, const IntersectionInfo& info) override;
 
-	virtual Spectrum Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) override;
+	virtual Spectrum Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler) override;
+
+	virtual LightBounds GetBounds() const override;
 };
 
 class SphereArea : public Light {
@@ -65,7 +86,9 @@ public:
 
 	virtual Spectrum Evaluate(const Vector3f& L, float& pdf, const IntersectionInfo& info) override;
 
-	virtual Spectrum Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) override;
+	virtual Spectrum Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler) override;
+
+	virtual LightBounds GetBounds() const override;
 };
 
 class InfiniteArea : public Light {
@@ -78,7 +101,7 @@ public:
 
 	virtual Spectrum EvaluateEnvironment(const Vector3f& L, float& pdf) override;
 
-	virtual Spectrum Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) override;
+	virtual Spectrum Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler) override;
 
 private:
 	std::shared_ptr<Hdr> hdr;
@@ -92,7 +115,9 @@ public:
 
 	virtual Spectrum Evaluate(const Vector3f& L, float& pdf, const IntersectionInfo& info) override;
 
-	virtual Spectrum Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) override;
+	virtual Spectrum Sample(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler) override;
+
+	virtual LightBounds GetBounds() const override;
 
 private:
 	std::vector<float> areas;
@@ -0,0 +1,205 @@
+#include "LightBVH.h"
+
+constexpr int LightBVHBuckets = 12;
+// Deeper subtrees split by count, which keeps every path within the 64 bits of the light bit trail
+constexpr int LightBVHMaxCostDepth = 32;
+
+LightBVH::LightBVH(const std::vector<std::shared_ptr<Light>>& lights) {
+	lightBits.assign(lights.size(), 0);
+	lightLeaf.assign(lights.size(), -1);
+
+	std::vector<BVHLight> bvhLights;
+	for (int i = 0; i < lights.size(); i++) {
+		LightBounds bounds = lights[i]->GetBounds();
+		if (bounds.phi > 0.0f) {
+			bvhLights.push_back({ i, bounds });
+		}
+	}
+
+	if (!bvhLights.empty()) {
+		nodes.reserve(2 * bvhLights.size() - 1);
+		Build(bvhLights, 0, bvhLights.size(), 0, 0);
+	}
+}
+
+int LightBVH::Build(std::vector<BVHLight>& bvhLights, int start, int end, uint64_t bits, int depth) {
+	int nodeIndex = nodes.size();
+	nodes.push_back(Node());
+
+	if (end - start == 1) {
+		nodes[nodeIndex] = { bvhLights[start].second, bvhLights[start].first, true };
+		lightBits[bvhLights[start].first] = bits;
+		lightLeaf[bvhLights[start].first] = nodeIndex;
+
+		return nodeIndex;
+	}
+
+	LightBounds bounds;
+	Point3f centroidMin(Infinity), centroidMax(-Infinity);
+	for (int i = start; i < end; i++) {
+		const LightBounds& lb = bvhLights[i].second;
+		bounds = LightBounds::Union(bounds, lb);
+		Point3f centroid = (lb.pMin + lb.pMax) * 0.5f;
+		centroidMin = glm::min(centroidMin, centroid);
+		centroidMax = glm::max(centroidMax, centroid);
+	}
+
+	// Bucketed split with the lowest cost over all three axes
+	float minCost = Infinity;
+	int minDim = -1, minBucket = -1;
+	if (depth < LightBVHMaxCostDepth) {
+		for (int dim = 0; dim < 3; dim++) {
+			float extent = centroidMax[dim] - centroidMin[dim];
+			if (extent <= 0.0f) {
+				continue;
+			}
+
+			LightBounds buckets[LightBVHBuckets];
+			for (int i = start; i < end; i++) {
+				const LightBounds& lb = bvhLights[i].second;
+				float centroid = (lb.pMin[dim] + lb.pMax[dim]) * 0.5f;
+				int b = std::min(static_cast<int>(LightBVHBuckets * (centroid - centroidMin[dim]) / extent), LightBVHBuckets - 1);
+				buckets[b] = LightBounds::Union(buckets[b], lb);
+			}
+
+			for (int split = 0; split < LightBVHBuckets - 1; split++) {
+				LightBounds below, above;
+				for (int b = 0; b <= split; b++) {
+					below = LightBounds::Union(below, buckets[b]);
+				}
+				for (int b = split + 1; b < LightBVHBuckets; b++) {
+					above = LightBounds::Union(above, buckets[b]);
+				}
+
+				float cost = EvaluateCost(below, bounds, dim) + EvaluateCost(above, bounds, dim);
+				if (below.phi > 0.0f && above.phi > 0.0f && cost < minCost) {
+					minCost = cost;
+					minDim = dim;
+					minBucket = split;
+				}
+			}
+		}
+	}
+
+	int mid;
+	if (minDim >= 0) {
+		float extent = centroidMax[minDim] - centroidMin[minDim];
+		auto pmid = std::partition(bvhLights.begin() + start, bvhLights.begin() + end, [&](const BVHLight& l) {
+			float centroid = (l.second.pMin[minDim] + l.second.pMax[minDim]) * 0.5f;
+			int b = std::min(static_cast<int>(LightBVHBuckets * (centroid - centroidMin[minDim]) / extent), LightBVHBuckets - 1);
+			return b <= minBucket;
+		});
+		mid = pmid - bvhLights.begin();
+	}
+	else {
+		// Coincident centroids or too deep, halve the range
+		mid = (start + end) / 2;
+	}
+	if (mid == start || mid == end) {
+		mid = (start + end) / 2;
+	}
+
+	// The first child follows its parent, only the second needs an index
+	Build(bvhLights, start, mid, bits, depth + 1);
+	int second = Build(bvhLights, mid, end, bits | (uint64_t(1) << depth), depth + 1);
+	nodes[nodeIndex] = { bounds, second, false };
+
+	return nodeIndex;
+}
+
+float LightBVH::EvaluateCost(const LightBounds& bounds, const LightBounds& parent, int dim) {
+	if (bounds.phi == 0.0f) {
+		return 0.0f;
+	}
+
+	// Solid angle measure of the normal cone widened by the emission falloff
+	float theta_o = std::acos(glm::clamp(bounds.cos_theta_o, -1.0f, 1.0f));
+	float theta_e = std::acos(glm::clamp(bounds.cos_theta_e, -1.0f, 1.0f));
+	float theta_w = std::min(theta_o + theta_e, PI);
+	float sin_theta_o = std::sin(theta_o);
+	float M_omega = 2.0f * PI * (1.0f - bounds.cos_theta_o) +
+		PI / 2.0f * (2.0f * theta_w * sin_theta_o - std::cos(theta_o - 2.0f * theta_w) - 2.0f * theta_o * sin_theta_o + bounds.cos_theta_o);
+
+	// Thin slabs along the split axis are not penalized for their small area
+	Vector3f d = parent.pMax - parent.pMin;
+	float Kr = d[dim] > 0.0f ? std::max(d.x, std::max(d.y, d.z)) / d[dim] : 1.0f;
+
+	Vector3f e = bounds.pMax - bounds.pMin;
+	float area = 2.0f * (e.x * e.y + e.x * e.z + e.y * e.z);
+
+	return bounds.phi * M_omega * Kr * area;
+}
+
+int LightBVH::Sample(const Point3f& p, const Vector3f& n, float u, float& pmf) const {
+	pmf = 0.0f;
+	if (nodes.empty()) {
+		return -1;
+	}
+
+	float prob = 1.0f;
+	int index = 0;
+	while (!nodes[index].leaf) {
+		const Node& node = nodes[index];
+		float ci0 = nodes[index + 1].bounds.Importance(p, n);
+		float ci1 = nodes[node.index].bounds.Importance(p, n);
+		if (ci0 == 0.0f && ci1 == 0.0f) {
+			return -1;
+		}
+
+		// The sample is rescaled to [0, 1) for the next level
+		float p0 = ci0 / (ci0 + ci1);
+		if (u < p0) {
+			index = index + 1;
+			u = std::min(u / p0, FloatOneMinusEpsilon);
+			prob *= p0;
+		}
+		else {
+			index = node.index;
+			u = std::min((u - p0) / (1.0f - p0), FloatOneMinusEpsilon);
+			prob *= 1.0f - p0;
+		}
+	}
+
+	// A lone light is still skipped where it cannot contribute
+	if (index == 0 && nodes[0].bounds.Importance(p, n) == 0.0f) {
+		return -1;
+	}
+	pmf = prob;
+
+	return nodes[index].index;
+}
+
+float LightBVH::PMF(const Point3f& p, const Vector3f& n, int light) const {
+	if (light < 0 || light >= lightLeaf.size() || lightLeaf[light] < 0) {
+		return 0.0f;
+	}
+
+	// Follow the bit trail of the light down from the root
+	uint64_t bits = lightBits[light];
+	float pmf = 1.0f;
+	int index = 0;
+	while (!nodes[index].leaf) {
+		const Node& node = nodes[index];
+		float ci0 = nodes[index + 1].bounds.Importance(p, n);
+		float ci1 = nodes[node.index].bounds.Importance(p, n);
+		if (ci0 == 0.0f && ci1 == 0.0f) {
+			return 0.0f;
+		}
+
+		if (bits & 1) {
+			pmf *= ci1 / (ci0 + ci1);
+			index = node.index;
+		}
+		else {
+			pmf *= ci0 / (ci0 + ci1);
+			index = index + 1;
+		}
+		bits >>= 1;
+	}
+
+	if (index == 0 && nodes[0].bounds.Importance(p, n) == 0.0f) {
+		return 0.0f;
+	}
+
+	return pmf;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Utils.h"
+#include "Light.h"
+
+// Bounding volume hierarchy over the bounded lights of a scene. Sampling walks down from the root and picks a child
+// in proportion to its importance to the shading point, so far away and facing away lights are rarely chosen.
+class LightBVH {
+public:
+	LightBVH() = default;
+
+	// Lights are referred to by their index in lights, those without bounds are left out
+	LightBVH(const std::vector<std::shared_ptr<Light>>& lights);
+
+	inline bool Empty() const {
+		return nodes.empty();
+	}
+
+	// Index of the chosen light and its probability, -1 if no light can reach p. n is zero inside media
+	int Sample(const Point3f& p, const Vector3f& n, float u, float& pmf) const;
+
+	// Probability of Sample choosing the light at p
+	float PMF(const Point3f& p, const Vector3f& n, int light) const;
+
+private:
+	struct Node {
+		LightBounds bounds;
+		int index;// second child of an interior node, light of a leaf
+		bool leaf;
+	};
+
+	typedef std::pair<int, LightBounds> BVHLight;
+
+	int Build(std::vector<BVHLight>& bvhLights, int start, int end, uint64_t bits, int depth);
+
+	// Relative cost of a node holding the given lights, lower for small bounds and narrow normal cones
+	static float EvaluateCost(const LightBounds& bounds, const LightBounds& parent, int dim);
+
+private:
+	std::vector<Node> nodes;
+	std::vector<uint64_t> lightBits;// path from the root to the leaf of each light, bit i set for the second child at depth i
+	std::vector<int> lightLeaf;// leaf node of each light, -1 for lights outside the tree
+};
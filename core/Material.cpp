@@ -21,7 +21,7 @@ Spectrum MediumBoundary::Evaluate(const Vector3f& V, const Vector3f& L, float& p
 	return Spectrum(0.0f);
 }
 
-Spectrum MediumBoundary::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum MediumBoundary::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	L = Vector3f(0.0f);
 	pdf = 0.0f;
 
@@ -38,7 +38,7 @@ Spectrum DiffuseLight::Evaluate(const Vector3f& V, const Vector3f& L, float& pdf
 	return Spectrum(0.0f);
 }
 
-Spectrum DiffuseLight::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum DiffuseLight::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	L = Vector3f(0.0f);
 	pdf = 0.0f;
 
@@ -81,7 +81,7 @@ Spectrum Diffuse::Evaluate(const Vector3f& V, const Vector3f& L, float& pdf, con
 	return brdf;
 }
 
-Spectrum Diffuse::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum Diffuse::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	Spectrum albedo = albedoTexture->GetColor(info.uv);
 	float roughness = roughnessTexture->GetColor(info.uv)[0];
 
@@ -90,7 +90,7 @@ Spectrum Diffuse::Sample(const Vector3f& V, Vector3f& L, float& pdf, const Inter
 		Spectrum tangentNormal = normalTexture->GetColor(info.uv);
 		N = NormalFromTangentToWorld(N, Vector3f(tangentNormal[0], tangentNormal[1], tangentNormal[2]));
 	}
-	Vector3f local_L = CosineSampleHemisphere(sampler->Get2());
+	Vector3f local_L = CosineSampleHemisphere(sampler.Get2());
 	L = ToWorld(local_L, N);
 	Vector3f H = glm::normalize(V + L);
 	float NdotL = local_L.z;
@@ -151,7 +151,7 @@ Spectrum Conductor::Evaluate(const Vector3f& V, const Vector3f& L, float& pdf, c
 	return brdf;
 }
 
-Spectrum Conductor::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum Conductor::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	Spectrum albedo = albedoTexture->GetColor(info.uv);
 	float alpha_u = glm::pow2(roughnessTexture_u->GetColor(info.uv)[0]);
 	float alpha_v = glm::pow2(roughnessTexture_v->GetColor(info.uv)[0]);
@@ -161,7 +161,7 @@ Spectrum Conductor::Sample(const Vector3f& V, Vector3f& L, float& pdf, const Int
 		Spectrum tangentNormal = normalTexture->GetColor(info.uv);
 		N = NormalFromTangentToWorld(N, Vector3f(tangentNormal[0], tangentNormal[1], tangentNormal[2]));
 	}
-	Vector3f H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler->Get2());
+	Vector3f H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler.Get2());
 	H = ToWorld(H, N);
 	L = glm::reflect(-V, H);
 
@@ -260,7 +260,7 @@ Spectrum Dielectric::Evaluate(const Vector3f& V, const Vector3f& L, float& pdf,
 	return bsdf;
 }
 
-Spectrum Dielectric::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum Dielectric::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	Spectrum albedo = albedoTexture->GetColor(info.uv);
 	float alpha_u = glm::pow2(roughnessTexture_u->GetColor(info.uv)[0]);
 	float alpha_v = glm::pow2(roughnessTexture_v->GetColor(info.uv)[0]);
@@ -271,14 +271,14 @@ Spectrum Dielectric::Sample(const Vector3f& V, Vector3f& L, float& pdf, const In
 		Spectrum tangentNormal = normalTexture->GetColor(info.uv);
 		N = NormalFromTangentToWorld(N, Vector3f(tangentNormal[0], tangentNormal[1], tangentNormal[2]));
 	}
-	Vector3f H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler->Get2());
+	Vector3f H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler.Get2());
 	H = ToWorld(H, N);
 
 	Spectrum bsdf;
 	float Dv = GGX::DistributionVisible(V, H, N, alpha_u, alpha_v);
 	float F = Fresnel::FresnelDielectric(V, H, etai_over_etat);
 	float D = GGX::Distribution(H, N, alpha_u, alpha_v);
-	if (sampler->Get1() < F) {
+	if (sampler.Get1() < F) {
 		L = glm::reflect(-V, H);
 
 		float NdotV = glm::dot(N, V);
@@ -386,7 +386,7 @@ Spectrum Plastic::Evaluate(const Vector3f& V, const Vector3f& L, float& pdf, con
 	return brdf;
 }
 
-Spectrum Plastic::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum Plastic::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	Spectrum kd = albedoTexture->GetColor(info.uv);
 	Spectrum ks = specularTexture->GetColor(info.uv);
 	float d_sum = kd[0] + kd[1] + kd[2];
@@ -413,8 +413,8 @@ Spectrum Plastic::Sample(const Vector3f& V, Vector3f& L, float& pdf, const Inter
 	Vector3f H;
 	float NdotL = 0.0f;
 	float NdotV = glm::dot(N, V);
-	if (sampler->Get1() < pdf_specular) {
-		H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler->Get2());
+	if (sampler.Get1() < pdf_specular) {
+		H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler.Get2());
 		H = ToWorld(H, N);
 		L = glm::reflect(-V, H);
 
@@ -426,7 +426,7 @@ Spectrum Plastic::Sample(const Vector3f& V, Vector3f& L, float& pdf, const Inter
 		}
 	}
 	else {
-		Vector3f local_L = CosineSampleHemisphere(sampler->Get2());
+		Vector3f local_L = CosineSampleHemisphere(sampler.Get2());
 		L = ToWorld(local_L, N);
 		H = glm::normalize(V + L);
 		Fi = Fresnel::FresnelDielectric(L, N, 1.0f / eta);
@@ -528,7 +528,7 @@ Spectrum ThinDielectric::Evaluate(const Vector3f& V, const Vector3f& L, float& p
 	return bsdf;
 }
 
-Spectrum ThinDielectric::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum ThinDielectric::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	Spectrum albedo = albedoTexture->GetColor(info.uv);
 	float alpha_u = glm::pow2(roughnessTexture_u->GetColor(info.uv)[0]);
 	float alpha_v = glm::pow2(roughnessTexture_v->GetColor(info.uv)[0]);
@@ -538,7 +538,7 @@ Spectrum ThinDielectric::Sample(const Vector3f& V, Vector3f& L, float& pdf, cons
 		Spectrum tangentNormal = normalTexture->GetColor(info.uv);
 		N = NormalFromTangentToWorld(N, Vector3f(tangentNormal[0], tangentNormal[1], tangentNormal[2]));
 	}
-	Vector3f H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler->Get2());
+	Vector3f H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler.Get2());
 	H = ToWorld(H, N);
 
 	Spectrum bsdf;
@@ -548,7 +548,7 @@ Spectrum ThinDielectric::Sample(const Vector3f& V, Vector3f& L, float& pdf, cons
 		F *= 2.0f / (1.0f + F);
 	}
 	float D = GGX::Distribution(H, N, alpha_u, alpha_v);
-	if (sampler->Get1() < F) {
+	if (sampler.Get1() < F) {
 		L = glm::reflect(-V, H);
 
 		float NdotV = glm::dot(N, V);
@@ -639,7 +639,7 @@ Spectrum MetalWorkflow::Evaluate(const Vector3f& V, const Vector3f& L, float& pd
 	return brdf;
 }
 
-Spectrum MetalWorkflow::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum MetalWorkflow::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	Spectrum albedo = albedoTexture->GetColor(info.uv);
 	float alpha_u = glm::pow2(roughnessTexture_u->GetColor(info.uv)[0]);
 	float alpha_v = glm::pow2(roughnessTexture_v->GetColor(info.uv)[0]);
@@ -662,8 +662,8 @@ Spectrum MetalWorkflow::Sample(const Vector3f& V, Vector3f& L, float& pdf, const
 
 	Vector3f H;
 	float NdotL = 0.0f;
-	if (sampler->Get1() < p_diffuse) {
-		Vector3f local_L = CosineSampleHemisphere(sampler->Get2());
+	if (sampler.Get1() < p_diffuse) {
+		Vector3f local_L = CosineSampleHemisphere(sampler.Get2());
 		L = ToWorld(local_L, N);
 		H = glm::normalize(V + L);
 
@@ -676,7 +676,7 @@ Spectrum MetalWorkflow::Sample(const Vector3f& V, Vector3f& L, float& pdf, const
 		}
 	}
 	else {
-		H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler->Get2());
+		H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler.Get2());
 		H = ToWorld(H, N);
 
 		L = glm::reflect(-V, H);
@@ -744,7 +744,7 @@ Spectrum ClearcoatedConductor::Evaluate(const Vector3f& V, const Vector3f& L, fl
 	return brdf;
 }
 
-Spectrum ClearcoatedConductor::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum ClearcoatedConductor::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	float alpha_u = glm::pow2(roughnessTexture_u->GetColor(info.uv)[0]);
 	float alpha_v = glm::pow2(roughnessTexture_v->GetColor(info.uv)[0]);
 
@@ -757,8 +757,8 @@ Spectrum ClearcoatedConductor::Sample(const Vector3f& V, Vector3f& L, float& pdf
 	Vector3f H;
 	float F = Fresnel::FresnelDielectric(V, N, 1.0f / 1.5f);
 	float coat_weight = coatWeight * F;
-	if (sampler->Get1() < coat_weight) {
-		H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler->Get2());
+	if (sampler.Get1() < coat_weight) {
+		H = GGX::SampleVisible(N, V, alpha_u, alpha_v, sampler.Get2());
 		H = ToWorld(H, N);
 		L = glm::reflect(-V, H);
 
@@ -839,7 +839,7 @@ Spectrum DiffuseTransmitter::Evaluate(const Vector3f& V, const Vector3f& L, floa
 	return albedo * INV_PI;
 }
 
-Spectrum DiffuseTransmitter::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum DiffuseTransmitter::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	Spectrum albedo = albedoTexture->GetColor(info.uv);
 
 	Vector3f N = info.Ns;
@@ -847,7 +847,7 @@ Spectrum DiffuseTransmitter::Sample(const Vector3f& V, Vector3f& L, float& pdf,
 		Spectrum tangentNormal = normalTexture->GetColor(info.uv);
 		N = NormalFromTangentToWorld(N, Vector3f(tangentNormal[0], tangentNormal[1], tangentNormal[2]));
 	}
-	Vector3f local_L = CosineSampleHemisphere(sampler->Get2());
+	Vector3f local_L = CosineSampleHemisphere(sampler.Get2());
 	N = -N;
 	L = ToWorld(local_L, N);
 	float NdotL = local_L.z;
@@ -878,7 +878,7 @@ Spectrum Mixture::Evaluate(const Vector3f& V, const Vector3f& L, float& pdf, con
 	return bsdf;
 }
 
-Spectrum Mixture::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum Mixture::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	float pdf1 = 0.0f;
 	Vector3f L1;
 	Spectrum bsdf1 = material1->Sample(V, L1, pdf1, info, sampler);
@@ -886,7 +886,7 @@ Spectrum Mixture::Sample(const Vector3f& V, Vector3f& L, float& pdf, const Inter
 	Vector3f L2;
 	Spectrum bsdf2 = material1->Sample(V, L2, pdf2, info, sampler);
 
-	if (sampler->Get1() < weight) {
+	if (sampler.Get1() < weight) {
 		L = L1;
 	}
 	else {
@@ -15,7 +15,7 @@ void Medium::EvaluateWavelength(const Spectrum& history, const Spectrum& albedo,
 	}
 }
 
-int Medium::SampleWavelength(const Spectrum& history, const Spectrum& albedo, std::shared_ptr<Sampler> sampler, std::vector<float>& pmf) {
+int Medium::SampleWavelength(const Spectrum& history, const Spectrum& albedo, Sampler& sampler, std::vector<float>& pmf) {
 	// Create empirical discrete distribution
 	Spectrum history_albedo = history * albedo;
 	std::vector<float> wave(Spectrum::nSamples);
@@ -30,7 +30,7 @@ int Medium::SampleWavelength(const Spectrum& history, const Spectrum& albedo, st
 	}
 
 	// Sample index of wavelength from empirical discrete distribution
-	int channel = waveTable.Sample(sampler->Get1());
+	int channel = waveTable.Sample(sampler.Get1());
 
 	return channel;
 }
@@ -81,7 +81,7 @@ Spectrum Homogeneous::EvaluateDistance(const Spectrum& history, bool scattered,
 	return transmittance;
 }
 
-Spectrum Homogeneous::SampleDistance(const Spectrum& history, float max_distance, float& distance, float& trans_pdf, bool& scattered, std::shared_ptr<Sampler> sampler) {
+Spectrum Homogeneous::SampleDistance(const Spectrum& history, float max_distance, float& distance, float& trans_pdf, bool& scattered, Sampler& sampler) {
 	distance = std::min(MaxFloat, distance);
 	scattered = false;
 	trans_pdf = 0.0f;
@@ -91,7 +91,7 @@ Spectrum Homogeneous::SampleDistance(const Spectrum& history, float max_distance
 	int channel = SampleWavelength(history, (sigma_s / sigma_t), sampler, pmf_wavelength);
 
 	// Sample collision-free distance
-	distance = -std::log(std::max(1.0f - sampler->Get1(), 0.0f)) / sigma_t[channel];
+	distance = -std::log(std::max(1.0f - sampler.Get1(), 0.0f)) / sigma_t[channel];
 
 	// Hit volume boundary, no collision
 	if (distance >= max_distance) {
@@ -23,17 +23,17 @@ public:
 		return m_type;
 	}
 
-	inline std::shared_ptr<PhaseFunction> GetPhaseFunction() const {
+	inline const std::shared_ptr<PhaseFunction>& GetPhaseFunction() const {
 		return phaseFunction;
 	}
 
 	virtual Spectrum EvaluateDistance(const Spectrum& history, bool scattered, float distance, float& trans_pdf) = 0;
 
-	virtual Spectrum SampleDistance(const Spectrum& history, float max_distance, float& distance, float& trans_pdf, bool& scattered, std::shared_ptr<Sampler> sampler) = 0;
+	virtual Spectrum SampleDistance(const Spectrum& history, float max_distance, float& distance, float& trans_pdf, bool& scattered, Sampler& sampler) = 0;
 
 	static void EvaluateWavelength(const Spectrum& history, const Spectrum& albedo, std::vector<float>& pmf);
 
-	static int SampleWavelength(const Spectrum& history, const Spectrum& albedo, std::shared_ptr<Sampler> sampler, std::vector<float>& pmf);
+	static int SampleWavelength(const Spectrum& history, const Spectrum& albedo, Sampler& sampler, std::vector<float>& pmf);
 
 	static std::shared_ptr<Medium> Create(const MediumParams& params);
 
@@ -48,7 +48,7 @@ public:
 
 	virtual Spectrum EvaluateDistance(const Spectrum& history, bool scattered, float distance, float& trans_pdf) override;
 
-	virtual Spectrum SampleDistance(const Spectrum& history, float max_distance, float& distance, float& trans_pdf, bool& scattered, std::shared_ptr<Sampler> sampler) override;
+	virtual Spectrum SampleDistance(const Spectrum& history, float max_distance, float& distance, float& trans_pdf, bool& scattered, Sampler& sampler) override;
 
 private:
 	Spectrum sigma_s;
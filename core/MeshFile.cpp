@@ -0,0 +1,151 @@
+#include "MeshFile.h"
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& file) {
+#ifdef _WIN32
+	HANDLE fileH = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileH == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	fileHandle = fileH;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileH, &fileSize) || fileSize.QuadPart == 0) {
+		return;
+	}
+
+	HANDLE mappingH = CreateFileMappingA(fileH, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingH == NULL) {
+		return;
+	}
+	mappingHandle = mappingH;
+
+	void* view = MapViewOfFile(mappingH, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL) {
+		return;
+	}
+	data = static_cast<const char*>(view);
+	size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return;
+	}
+
+	void* view = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping keeps its own reference to the file
+	close(fd);
+	if (view == MAP_FAILED) {
+		return;
+	}
+	// the BVH build touches every page, read them ahead
+	madvise(view, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+
+	data = static_cast<const char*>(view);
+	size = static_cast<size_t>(st.st_size);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+	if (data != NULL) {
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle != NULL) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != NULL) {
+		CloseHandle(fileHandle);
+	}
+#else
+	if (data != NULL) {
+		munmap(const_cast<char*>(data), size);
+	}
+#endif
+	data = NULL;
+	size = 0;
+}
+
+// Offset of a block of the given size, checked to be aligned and to lie inside the file
+static bool ValidBlock(uint64_t offset, uint64_t bytes, size_t fileSize) {
+	return offset % MeshFileAlignment == 0 && offset <= fileSize && bytes <= fileSize - offset;
+}
+
+const MeshFileHeader* GetMeshFileHeader(const MappedFile& mapped) {
+	if (!mapped.IsValid() || mapped.GetSize() < sizeof(MeshFileHeader)) {
+		return NULL;
+	}
+
+	const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(mapped.GetData());
+	if (memcmp(header->magic, MeshFileMagic, sizeof(MeshFileMagic)) != 0 || header->version != MeshFileVersion) {
+		return NULL;
+	}
+
+	const uint64_t vertices = header->vertices;
+	const uint64_t faces = header->faces;
+	if (!ValidBlock(header->positionOffset, (3 * vertices + 1) * sizeof(float), mapped.GetSize()) ||
+		!ValidBlock(header->indexOffset, 3 * faces * sizeof(uint32_t), mapped.GetSize()) ||
+		!ValidBlock(header->normalOffset, 3 * vertices * sizeof(float), mapped.GetSize()) ||
+		!ValidBlock(header->texcoordOffset, 2 * vertices * sizeof(float), mapped.GetSize())) {
+		return NULL;
+	}
+
+	return header;
+}
+
+// Append a block at the next aligned offset and return that offset
+static uint64_t WriteBlock(std::ofstream& out, const void* data, uint64_t bytes) {
+	static const char zeros[MeshFileAlignment] = {};
+	uint64_t offset = static_cast<uint64_t>(out.tellp());
+	uint64_t aligned = (offset + MeshFileAlignment - 1) / MeshFileAlignment * MeshFileAlignment;
+	out.write(zeros, aligned - offset);
+	out.write(static_cast<const char*>(data), bytes);
+
+	return aligned;
+}
+
+bool WriteMeshFile(const std::string& file, uint32_t vertices, uint32_t faces, const float* positions,
+	const uint32_t* indices, const float* normals, const float* texcoords) {
+	std::ofstream out(file, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		return false;
+	}
+
+	MeshFileHeader header = {};
+	memcpy(header.magic, MeshFileMagic, sizeof(MeshFileMagic));
+	header.version = MeshFileVersion;
+	header.vertices = vertices;
+	header.faces = faces;
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	// positions are written with the padding float Embree needs
+	const float padding = 0.0f;
+	header.positionOffset = WriteBlock(out, positions, 3 * static_cast<uint64_t>(vertices) * sizeof(float));
+	out.write(reinterpret_cast<const char*>(&padding), sizeof(padding));
+	header.indexOffset = WriteBlock(out, indices, 3 * static_cast<uint64_t>(faces) * sizeof(uint32_t));
+	header.normalOffset = WriteBlock(out, normals, 3 * static_cast<uint64_t>(vertices) * sizeof(float));
+	header.texcoordOffset = WriteBlock(out, texcoords, 2 * static_cast<uint64_t>(vertices) * sizeof(float));
+
+	// the block offsets are only known now
+	out.seekp(0);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	return static_cast<bool>(out);
+}
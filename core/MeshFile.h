@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Utils.h"
+
+// Binary mesh container written by tools/MeshConverter, stored in native byte order.
+// The header is followed by position, index, normal and texcoord blocks, each starting at a multiple of MeshFileAlignment.
+// The position block holds 3 * vertices + 1 floats, the last float is the padding Embree reads past the final vertex.
+struct MeshFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t vertices;
+	uint32_t faces;
+	uint64_t positionOffset;
+	uint64_t indexOffset;
+	uint64_t normalOffset;
+	uint64_t texcoordOffset;
+};
+
+constexpr char MeshFileMagic[4] = { 'D', 'R', 'M', 'F' };
+constexpr uint32_t MeshFileVersion = 1;
+constexpr uint64_t MeshFileAlignment = 64;
+
+// Read-only mapping of a whole file, its pages stay in the OS page cache between runs
+class MappedFile {
+public:
+	MappedFile(const std::string& file);
+
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	inline bool IsValid() const {
+		return data != NULL;
+	}
+
+	inline const char* GetData() const {
+		return data;
+	}
+
+	inline size_t GetSize() const {
+		return size;
+	}
+
+private:
+	const char* data = NULL;
+	size_t size = 0;
+	// Windows file and mapping handles, unused on POSIX
+	void* fileHandle = NULL;
+	void* mappingHandle = NULL;
+};
+
+// Header of a mapped mesh file, NULL if the file is not a mesh file of this version or its blocks run past the end
+const MeshFileHeader* GetMeshFileHeader(const MappedFile& mapped);
+
+// Write a mesh file, positions must hold 3 * vertices floats, normals 3 * vertices and texcoords 2 * vertices
+bool WriteMeshFile(const std::string& file, uint32_t vertices, uint32_t faces, const float* positions,
+	const uint32_t* indices, const float* normals, const float* texcoords);
@@ -7,9 +7,9 @@ Spectrum Isotropic::Evaluate(const Vector3f& V, const Vector3f& L, float& pdf, c
 	return attenuation;
 }
 
-Spectrum Isotropic::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
+Spectrum Isotropic::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
 	Spectrum attenuation(INV_4PI);
-	L = UniformSampleSphere(sampler->Get2());
+	L = UniformSampleSphere(sampler.Get2());
 	pdf = UniformPdfSphere();
 
 	return attenuation;
@@ -36,16 +36,16 @@ Spectrum HenyeyGreenstein::Evaluate(const Vector3f& V, const Vector3f& L, float&
 	return attenuation;
 }
 
-Spectrum HenyeyGreenstein::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
-	int channel = std::min(static_cast<int>(sampler->Get1() * 3), 2);
+Spectrum HenyeyGreenstein::Sample(const Vector3f& V, Vector3f& L, float& pdf, const IntersectionInfo& info, Sampler& sampler) {
+	int channel = std::min(static_cast<int>(sampler.Get1() * 3), 2);
 	float gc = g[channel];
 
 	float cos_theta = 0.0f;
 	if (std::abs(gc) < Epsilon) {
-		cos_theta = 1.0f - 2.0f * sampler->Get1();
+		cos_theta = 1.0f - 2.0f * sampler.Get1();
 	}
 	else {
-		float sqr_term = (1.0f - gc * gc) / (1.0f - gc + 2.0f * gc * sampler->Get1());
+		float sqr_term = (1.0f - gc * gc) / (1.0f - gc + 2.0f * gc * sampler.Get1());
 		cos_theta = (1.0f + gc * gc - sqr_term * sqr_term) / (2.0f * gc);
 	}
 
@@ -65,7 +65,7 @@ Spectrum HenyeyGreenstein::Sample(const Vector3f& V, Vector3f& L, float& pdf, co
 	}
 
 	float sin_theta = std::sqrt(std::max(0.0f, 1.0f - cos_theta * cos_theta));
-	float phi = 2.0f * PI * sampler->Get1();
+	float phi = 2.0f * PI * sampler.Get1();
 
 	Vector3f local_L = glm::normalize(Vector3f(sin_theta * cos(phi), sin_theta * sin(phi), cos_theta));
 	L = ToWorld(local_L, V);
@@ -1,123 +1,97 @@
 #include "Renderer.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
 
-unsigned int Renderer::GetTextureRGB32F(int w, int h) {
-	unsigned int texture;
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, w, h, 0, GL_RGB, GL_FLOAT, 0);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	return texture;
-}
-
-Renderer::Renderer(std::shared_ptr<Integrator> inte, std::shared_ptr<PostProcessing> p) {
+Renderer::Renderer(std::shared_ptr<Integrator> inte, std::shared_ptr<PostProcessing> p) : integrator(inte), post(p) {
 	width = inte->width;
 	height = inte->height;
-	integrator = inte;
-	post = p;
-	frameCounter = 0;
-
-#pragma region InitOpenGL
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-	window = glfwCreateWindow(width, height, "DreamRender", NULL, NULL);
-	if (window == NULL) {
-		std::cout << "Init Window failed!" << std::endl;
-		glfwTerminate();
-
-		assert(0);
-	}
-	glfwMakeContextCurrent(window);
-
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-		std::cout << "Init glad failed!" << std::endl;
+	film = std::make_shared<Film>(width, height);
+}
 
-		assert(0);
+Batch::Batch(std::shared_ptr<Integrator> inte, std::shared_ptr<PostProcessing> p, int spp, double budget, const std::string& file, int sppPerPass) :
+	Renderer(inte, p), maxSamples(spp), samplesPerPass(std::max(sppPerPass, 1)), timeBudget(budget), output(file) {
+	// Without any stop condition render a single sample
+	if (maxSamples <= 0 && timeBudget <= 0.0) {
+		maxSamples = 1;
 	}
-
-	glViewport(0, 0, width, height);
-#pragma endregion
-
-#pragma region PipelineConfiguration
-	Shader shader1("shader/VertexShader.vert", "shader/MixFrameShader.frag");
-	Shader shader2("shader/VertexShader.vert", "shader/LastFrameShader.frag");
-	Shader shader3("shader/VertexShader.vert", "shader/OutputShader.frag");
-
-	pass1.program = shader1.ID;
-	pass1.width = width;
-	pass1.height = height;
-	pass1.colorAttachments.push_back(GetTextureRGB32F(pass1.width, pass1.height));
-	pass1.BindData();
-
-	pass2.program = shader2.ID;
-	pass2.width = width;
-	pass2.height = height;
-	lastFrame = GetTextureRGB32F(pass2.width, pass2.height);
-	pass2.colorAttachments.push_back(lastFrame);
-	pass2.BindData();
-
-	pass3.program = shader3.ID;
-	pass3.width = width;
-	pass3.height = height;
-	pass3.BindData(true);
-#pragma endregion
 }
 
-Renderer::~Renderer() {
-	glfwDestroyWindow(window);
-	glfwTerminate();
-}
+void Batch::Run() {
+	unsigned int sampleCounter = 0;
 
-void Renderer::Run() {
-	RGBSpectrum* nowTexture = new RGBSpectrum[width * height];
-	nowFrame = GetTextureRGB32F(width, height);
+	auto t1 = std::chrono::steady_clock::now();
+	while (maxSamples <= 0 || sampleCounter < maxSamples) {
+		int spp = maxSamples <= 0 ? samplesPerPass : std::min<int>(samplesPerPass, maxSamples - sampleCounter);
+		integrator->RenderImage(spp, film);
+		sampleCounter += spp;
 
-	while (!glfwWindowShouldClose(window)) {
-		t2 = clock();
-		dt = (double)(t2 - t1) / CLOCKS_PER_SEC;
-		fps = 1.0 / dt;
+		double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
 		std::cout << "\r";
-		std::cout << std::fixed << std::setprecision(2) << "FPS : " << fps << "    FrameCounter: " << frameCounter;
-		t1 = t2;
-
-		integrator->RenderImage(post, nowTexture);
+		std::cout << std::fixed << std::setprecision(2) << "Time : " << dt << "s    SampleCounter: " << sampleCounter;
 
-		glBindTexture(GL_TEXTURE_2D, nowFrame);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, width, height, 0, GL_RGB, GL_FLOAT, nowTexture);
+		if (timeBudget > 0.0 && dt >= timeBudget) {
+			break;
+		}
 
-		glUseProgram(pass1.program);
-
-		glUniform1ui(glGetUniformLocation(pass1.program, "frameCounter"), frameCounter++);
+		float threshold = integrator->GetNoiseThreshold();
+		if (threshold > 0.0f && film->CountConverged(integrator->GetScheduler()->GetTiles(), threshold, integrator->GetMinSamples()) ==
+			integrator->GetScheduler()->GetTiles().size()) {
+			break;
+		}
+	}
+	std::cout << std::endl;
+	integrator->GetScheduler()->ReportTileCosts();
+	film->ReportSampleCounts(integrator->GetScheduler()->GetTiles());
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, nowFrame);
-		glUniform1i(glGetUniformLocation(pass1.program, "nowFrame"), 0);
+	if (!WriteImage()) {
+		std::cout << "Write image " << output << " failed!" << std::endl;
+	}
+}
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, lastFrame);
-		glUniform1i(glGetUniformLocation(pass1.program, "lastFrame"), 1);
+bool Batch::WriteImage() const {
+	std::string ext = std::filesystem::path(output).extension().string();
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+
+	// Row 0 of the frame is the bottom of the image
+	stbi_flip_vertically_on_write(1);
+
+	// Hdr keeps the linear radiance, every other format gets the tone mapped colors
+	if (ext == ".hdr") {
+		std::vector<float> color(3 * width * height);
+		for (int j = 0; j < height; j++) {
+			for (int i = 0; i < width; i++) {
+				RGBSpectrum pixel = film->GetPixel(i, j);
+				for (int c = 0; c < 3; c++) {
+					color[3 * (j * width + i) + c] = pixel[c];
+				}
+			}
+		}
+
+		return stbi_write_hdr(output.c_str(), width, height, 3, color.data()) != 0;
+	}
 
-		pass1.Draw();
-		pass2.Draw(pass1.colorAttachments);
-		pass3.Draw(pass2.colorAttachments);
+	std::vector<RGBSpectrum> screen(width * height);
+	film->Resolve(post, screen.data());
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+	std::vector<unsigned char> ldr(3 * width * height);
+	for (int i = 0; i < width * height; i++) {
+		for (int c = 0; c < 3; c++) {
+			ldr[3 * i + c] = static_cast<unsigned char>(glm::clamp(screen[i][c], 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
 	}
 
-	if (nowTexture != NULL) {
-		delete[] nowTexture;
-		nowTexture = NULL;
+	if (ext == ".png") {
+		return stbi_write_png(output.c_str(), width, height, 3, ldr.data(), 3 * width) != 0;
+	}
+	else if (ext == ".jpg" || ext == ".jpeg") {
+		return stbi_write_jpg(output.c_str(), width, height, 3, ldr.data(), 95) != 0;
+	}
+	else if (ext == ".bmp") {
+		return stbi_write_bmp(output.c_str(), width, height, 3, ldr.data()) != 0;
+	}
+	else if (ext == ".tga") {
+		return stbi_write_tga(output.c_str(), width, height, 3, ldr.data()) != 0;
 	}
-}
 
-std::shared_ptr<Renderer> Renderer::Create(const RendererParams& params) {
-	return std::make_shared<Renderer>(params.integrator, params.post);
-}
+	return false;
+}
\ No newline at end of file
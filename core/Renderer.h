@@ -2,8 +2,6 @@
 
 #include "Utils.h"
 #include "Integrator.h"
-#include "Shader.h"
-#include "RenderPass.h"
 
 struct RendererParams {
 	std::shared_ptr<Integrator> integrator;
@@ -14,25 +12,30 @@ class Renderer {
 public:
 	Renderer(std::shared_ptr<Integrator> inte, std::shared_ptr<PostProcessing> p);
 
-	~Renderer();
+	virtual ~Renderer() = default;
 
-	void Run();
+	virtual void Run() = 0;
 
-	static std::shared_ptr<Renderer> Create(const RendererParams& params);
+protected:
+	std::shared_ptr<Integrator> integrator;
+	std::shared_ptr<PostProcessing> post;
+	std::shared_ptr<Film> film;
+	int width, height;
+};
+
+// Headless renderer, accumulates passes of sppPerPass samples in the film and writes the result to disk
+class Batch : public Renderer {
+public:
+	Batch(std::shared_ptr<Integrator> inte, std::shared_ptr<PostProcessing> p, int spp, double budget, const std::string& file, int sppPerPass = 4);
+
+	virtual void Run() override;
 
 private:
-	unsigned int GetTextureRGB32F(int w, int h);
+	bool WriteImage() const;
 
 private:
-	std::shared_ptr<Integrator> integrator;
-	std::shared_ptr<PostProcessing> post;
-	GLFWwindow* window;
-	unsigned int lastFrame, nowFrame;
-	int width, height;
-	clock_t t1, t2;
-	double dt, fps;
-	unsigned int frameCounter;
-	RenderPass pass1;
-	RenderPass pass2;
-	RenderPass pass3;
+	int maxSamples;
+	int samplesPerPass;
+	double timeBudget;
+	std::string output;
 };
\ No newline at end of file
@@ -1,27 +1,42 @@
 #include "Sampler.h"
 #include "SobolMatrices1024x52.h"
 
-Independent::Independent() : Sampler(SamplerType::IndependentSampler) {
-	rng.seed(GlobalRandomEngine());
+Independent::Independent(uint32_t seed) : seed(seed), Sampler(SamplerType::IndependentSampler) {
+	pixelKey = MixBits(static_cast<uint64_t>(seed) << 32);
 }
 
 float Independent::Get1() {
-	return std::uniform_real_distribution<float>(0.0f, FloatOneMinusEpsilon)(rng);
+	uint32_t r = Philox4x32(index, NextDimension(), pixelKey);
+
+	return std::min(static_cast<float>(r) * 0x1p-32f, FloatOneMinusEpsilon);
+}
+
+std::shared_ptr<Sampler> Independent::Clone() const {
+	return std::make_shared<Independent>(*this);
 }
 
 void Independent::SetPixel(int x, int y) {
-	rng.seed(GlobalRandomEngine());
+	uint64_t pixel = (static_cast<uint64_t>(y) << 32) | static_cast<uint32_t>(x);
+	pixelKey = MixBits(pixel ^ MixBits(static_cast<uint64_t>(seed) << 32));
+	ResetDimensions();
 }
 
 void Independent::NextSample() {
-	rng.seed(GlobalRandomEngine());
+	index++;
+	ResetDimensions();
 }
 
 void Independent::NextSamples(size_t samples) {
-	rng.seed(GlobalRandomEngine());
+	index += samples;
+	ResetDimensions();
+}
+
+void Independent::SetSampleIndex(uint64_t i) {
+	index = i;
+	ResetDimensions();
 }
 
-SimpleSobol::SimpleSobol(uint32_t seed) : seed(seed), scramble(seed), Sampler(SamplerType::SimpleSobolSampler) {}
+SimpleSobol::SimpleSobol(uint32_t seed) : seed(seed), scramble(seed), pixelKey(seed), Sampler(SamplerType::SimpleSobolSampler) {}
 
 uint32_t SobolSample(uint64_t index, int dim, uint32_t scramble = 0) {
 	uint32_t r = scramble;
@@ -35,34 +50,383 @@ uint32_t SobolSample(uint64_t index, int dim, uint32_t scramble = 0) {
 }
 
 float SimpleSobol::Get1() {
-	float r = static_cast<float>(SobolSample(index, dim++, scramble)) * 0x1p-32f;
+	int d = NextDimension();
+	uint32_t v = d < SobolMatricesDim ? SobolSample(index, d, scramble) : Philox4x32(index, d, pixelKey);
 
-	return std::min(r, FloatOneMinusEpsilon);
+	return std::min(static_cast<float>(v) * 0x1p-32f, FloatOneMinusEpsilon);
+}
+
+std::shared_ptr<Sampler> SimpleSobol::Clone() const {
+	return std::make_shared<SimpleSobol>(*this);
 }
 
 void SimpleSobol::SetPixel(int x, int y) {
-	dim = 0;
-	rng.seed(y << 16 | x);
-	scramble = rng();
+	ResetDimensions();
+	uint64_t pixel = (static_cast<uint64_t>(y) << 32) | static_cast<uint32_t>(x);
+	pixelKey = MixBits(pixel ^ MixBits(seed));
+	scramble = static_cast<uint32_t>(pixelKey);
 }
 
 void SimpleSobol::NextSample() {
 	index++;
-	dim = 0;
+	ResetDimensions();
 }
 
 void SimpleSobol::NextSamples(size_t samples) {
 	index += samples;
-	dim = 0;
+	ResetDimensions();
+}
+
+void SimpleSobol::SetSampleIndex(uint64_t i) {
+	index = i;
+	ResetDimensions();
+}
+
+// Columns of every Sobol matrix stored bit-major, so one Gray-code step touches contiguous memory
+static const std::vector<uint32_t>& SobolColumns() {
+	static const std::vector<uint32_t> columns = [] {
+		std::vector<uint32_t> c(SobolMatricesDim * SobolMatricesSize);
+		for (int d = 0; d < SobolMatricesDim; d++) {
+			for (int b = 0; b < SobolMatricesSize; b++) {
+				c[b * SobolMatricesDim + d] = SobolMatrices[d * SobolMatricesSize + b];
+			}
+		}
+
+		return c;
+	}();
+
+	return columns;
+}
+
+inline uint32_t ReverseBits32(uint32_t v) {
+	v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+	v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+	v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+	v = ((v >> 8) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8);
+
+	return (v >> 16) | (v << 16);
+}
+
+// Hash based nested uniform scramble, Burley 2020 "Practical Hash-based Owen Scrambling"
+inline uint32_t OwenScramble(uint32_t v, uint32_t seed) {
+	v = ReverseBits32(v);
+	v += seed;
+	v ^= v * 0x6c50b47cu;
+	v ^= v * 0xb82f1e52u;
+	v ^= v * 0xc7afe638u;
+	v ^= v * 0x8d22f6e6u;
+
+	return ReverseBits32(v);
+}
+
+OwenSobol::OwenSobol(uint32_t seed) : seed(seed), Sampler(SamplerType::OwenSobolSampler) {
+	pixelKey = MixBits(static_cast<uint64_t>(seed) << 32);
+	sobol.resize(SobolMatricesDim);
+	seeds.resize(SobolMatricesDim);
+	SobolColumns();
+}
+
+const uint32_t* OwenSobol::SobolValues(int dims) {
+	if (index != cachedIndex) {
+		if (cachedDims > 0 && index == cachedIndex + 1) {
+			// Gray codes of consecutive indices differ in the lowest set bit of the index
+			int bit = 0;
+			while (((index >> bit) & 1) == 0) {
+				bit++;
+			}
+
+			const uint32_t* column = &SobolColumns()[bit * SobolMatricesDim];
+			for (int k = 0; k < cachedDims; k++) {
+				sobol[k] ^= column[k];
+			}
+		}
+		else {
+			cachedDims = 0;
+		}
+		cachedIndex = index;
+	}
+
+	while (cachedDims < dims) {
+		sobol[cachedDims] = SobolSample(index ^ (index >> 1), cachedDims);
+		cachedDims++;
+	}
+
+	return sobol.data();
+}
+
+const uint32_t* OwenSobol::ScrambleSeeds(int dims) {
+	while (seededDims < dims) {
+		seeds[seededDims] = static_cast<uint32_t>(MixBits(pixelKey ^ seededDims));
+		seededDims++;
+	}
+
+	return seeds.data();
+}
+
+void OwenSobol::GetN(float* values, int n) {
+	int first = dim;
+	if (first + n > dimEnd || first + n > SobolMatricesDim) {
+		// The block runs out within the call, dimension by dimension
+		for (int k = 0; k < n; k++) {
+			int d = NextDimension();
+			uint32_t v = 0;
+			if (d < SobolMatricesDim) {
+				v = OwenScramble(SobolValues(d + 1)[d], ScrambleSeeds(d + 1)[d]);
+			}
+			else {// Hashed dimension
+				v = Philox4x32(index, d, pixelKey);
+			}
+			values[k] = std::min(static_cast<float>(v) * 0x1p-32f, FloatOneMinusEpsilon);
+		}
+
+		return;
+	}
+	dim += n;
+
+	// Contiguous dimensions, one cache lookup for all of them and a loop without branches
+	const uint32_t* sobolValues = SobolValues(first + n) + first;
+	const uint32_t* scrambleSeeds = ScrambleSeeds(first + n) + first;
+	for (int k = 0; k < n; k++) {
+		values[k] = std::min(static_cast<float>(OwenScramble(sobolValues[k], scrambleSeeds[k])) * 0x1p-32f, FloatOneMinusEpsilon);
+	}
+}
+
+float OwenSobol::Get1() {
+	float v;
+	GetN(&v, 1);
+
+	return v;
+}
+
+Point2f OwenSobol::Get2() {
+	float v[2];
+	GetN(v, 2);
+
+	return { v[0], v[1] };
+}
+
+Point3f OwenSobol::Get3() {
+	float v[3];
+	GetN(v, 3);
+
+	return { v[0], v[1], v[2] };
+}
+
+Point4f OwenSobol::Get4() {
+	float v[4];
+	GetN(v, 4);
+
+	return { v[0], v[1], v[2], v[3] };
+}
+
+std::shared_ptr<Sampler> OwenSobol::Clone() const {
+	return std::make_shared<OwenSobol>(*this);
+}
+
+void OwenSobol::SetPixel(int x, int y) {
+	uint64_t pixel = (static_cast<uint64_t>(y) << 32) | static_cast<uint32_t>(x);
+	pixelKey = MixBits(pixel ^ MixBits(static_cast<uint64_t>(seed) << 32));
+	seededDims = 0;
+	ResetDimensions();
+}
+
+void OwenSobol::NextSample() {
+	index++;
+	ResetDimensions();
+}
+
+void OwenSobol::NextSamples(size_t samples) {
+	index += samples;
+	ResetDimensions();
+}
+
+void OwenSobol::SetSampleIndex(uint64_t i) {
+	index = i;
+	ResetDimensions();
+}
+
+constexpr int BlueNoiseSize = 64;
+constexpr int LatticeDimensions = CameraDimensions + SobolBounces * BounceDimensions;
+
+// Ranks of a void-and-cluster blue-noise mask (Ulichney 1993), built once on first use
+static const std::vector<float>& BlueNoiseMask() {
+	static const std::vector<float> mask = [] {
+		const int n = BlueNoiseSize * BlueNoiseSize;
+		const float sigma = 1.5f;
+
+		// Toroidal Gaussian energy of a point at every offset
+		std::vector<float> kernel(n);
+		for (int y = 0; y < BlueNoiseSize; y++) {
+			for (int x = 0; x < BlueNoiseSize; x++) {
+				int dx = std::min(x, BlueNoiseSize - x);
+				int dy = std::min(y, BlueNoiseSize - y);
+				kernel[y * BlueNoiseSize + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+			}
+		}
+
+		std::vector<char> pattern(n, 0);
+		std::vector<float> energy(n, 0.0f);
+		auto Toggle = [&](int p, bool on) {
+			pattern[p] = on;
+			int px = p % BlueNoiseSize, py = p / BlueNoiseSize;
+			float sign = on ? 1.0f : -1.0f;
+			for (int y = 0; y < BlueNoiseSize; y++) {
+				int ky = ((y - py + BlueNoiseSize) % BlueNoiseSize) * BlueNoiseSize;
+				for (int x = 0; x < BlueNoiseSize; x++) {
+					energy[y * BlueNoiseSize + x] += sign * kernel[ky + (x - px + BlueNoiseSize) % BlueNoiseSize];
+				}
+			}
+		};
+		// Tightest cluster among the set points, largest void among the empty ones
+		auto Find = [&](bool on) {
+			int best = -1;
+			for (int p = 0; p < n; p++) {
+				if (pattern[p] == on && (best < 0 || (on ? energy[p] > energy[best] : energy[p] < energy[best]))) {
+					best = p;
+				}
+			}
+
+			return best;
+		};
+
+		// Initial binary pattern, random points relaxed until the tightest cluster is the largest void
+		int ones = n / 10;
+		for (int k = 0; k < ones; k++) {
+			int p = static_cast<int>(MixBits(k) % n);
+			while (pattern[p]) {
+				p = (p + 1) % n;
+			}
+			Toggle(p, true);
+		}
+		while (true) {
+			int cluster = Find(true);
+			Toggle(cluster, false);
+			int hole = Find(false);
+			Toggle(hole, true);
+			if (hole == cluster) {
+				break;
+			}
+		}
+		std::vector<char> prototype = pattern;
+		std::vector<float> prototypeEnergy = energy;
+
+		// Ranks of the initial points, removing the tightest cluster first
+		std::vector<int> rank(n, 0);
+		for (int r = ones - 1; r >= 0; r--) {
+			int cluster = Find(true);
+			Toggle(cluster, false);
+			rank[cluster] = r;
+		}
+
+		// Ranks of the remaining points, filling the largest void first
+		pattern = prototype;
+		energy = prototypeEnergy;
+		for (int r = ones; r < n; r++) {
+			int hole = Find(false);
+			Toggle(hole, true);
+			rank[hole] = r;
+		}
+
+		std::vector<float> m(n);
+		for (int p = 0; p < n; p++) {
+			m[p] = (rank[p] + 0.5f) / n;
+		}
+
+		return m;
+	}();
+
+	return mask;
+}
+
+// Generating vector of the lattice, the fractional parts of the square roots of the primes
+static const std::vector<double>& LatticeAlphas() {
+	static const std::vector<double> alphas = [] {
+		std::vector<double> a;
+		for (int p = 2; a.size() < LatticeDimensions; p++) {
+			bool prime = true;
+			for (int q = 2; q * q <= p; q++) {
+				if (p % q == 0) {
+					prime = false;
+
+					break;
+				}
+			}
+			if (prime) {
+				double r = std::sqrt(static_cast<double>(p));
+				a.push_back(r - std::floor(r));
+			}
+		}
+
+		return a;
+	}();
+
+	return alphas;
+}
+
+BlueNoise::BlueNoise(uint32_t seed) : seed(seed), Sampler(SamplerType::BlueNoiseSampler) {
+	BlueNoiseMask();
+	LatticeAlphas();
+}
+
+float BlueNoise::Get1() {
+	int d = NextDimension();
+	if (d >= LatticeDimensions) {// Hashed dimension
+		uint64_t pixel = (static_cast<uint64_t>(py) << 32) | static_cast<uint32_t>(px);
+		uint32_t v = Philox4x32(index, d, MixBits(pixel ^ seed));
+
+		return std::min(static_cast<float>(v) * 0x1p-32f, FloatOneMinusEpsilon);
+	}
+
+	// Every dimension reads the mask through its own toroidal shift
+	uint32_t shift = static_cast<uint32_t>(MixBits(static_cast<uint64_t>(d) ^ (static_cast<uint64_t>(seed) << 32)));
+	int mx = (px + (shift & 0xFFFF)) % BlueNoiseSize;
+	int my = (py + (shift >> 16)) % BlueNoiseSize;
+	double offset = BlueNoiseMask()[my * BlueNoiseSize + mx];
+
+	double v = offset + static_cast<double>(index) * LatticeAlphas()[d];
+	v -= std::floor(v);
+
+	return std::min(static_cast<float>(v), FloatOneMinusEpsilon);
+}
+
+std::shared_ptr<Sampler> BlueNoise::Clone() const {
+	return std::make_shared<BlueNoise>(*this);
+}
+
+void BlueNoise::SetPixel(int x, int y) {
+	px = x;
+	py = y;
+	ResetDimensions();
+}
+
+void BlueNoise::NextSample() {
+	index++;
+	ResetDimensions();
+}
+
+void BlueNoise::NextSamples(size_t samples) {
+	index += samples;
+	ResetDimensions();
+}
+
+void BlueNoise::SetSampleIndex(uint64_t i) {
+	index = i;
+	ResetDimensions();
 }
 
 std::shared_ptr<Sampler> Sampler::Create(const SamplerParams& params) {
 	if (params.type == SamplerType::IndependentSampler) {
-		return std::make_shared<Independent>();
+		return std::make_shared<Independent>(params.seed);
 	}
 	else if (params.type == SamplerType::SimpleSobolSampler) {
 		return std::make_shared<SimpleSobol>(params.seed);
 	}
+	else if (params.type == SamplerType::OwenSobolSampler) {
+		return std::make_shared<OwenSobol>(params.seed);
+	}
+	else if (params.type == SamplerType::BlueNoiseSampler) {
+		return std::make_shared<BlueNoise>(params.seed);
+	}
 
 	return NULL;
 }
@@ -2,11 +2,53 @@
 
 #include "Utils.h"
 
-static std::default_random_engine GlobalRandomEngine(time(0));
+// Finalizer of MurmurHash3, spreads pixel coordinates and sample index over every bit of a seed
+inline uint64_t MixBits(uint64_t v) {
+	v ^= (v >> 31);
+	v *= 0x7fb5d329728ea185ull;
+	v ^= (v >> 27);
+	v *= 0x81dadef4bc2dd44dull;
+	v ^= (v >> 33);
+
+	return v;
+}
+
+// Philox4x32-10 counter-based generator, a pure function of (counter, key) with no state to set up.
+// The 64-bit sample index and the dimension fill the counter words, the whole 64-bit pixel hash is the key,
+// so distinct pixels never share a stream. Returns the first word of the output block
+inline uint32_t Philox4x32(uint64_t index, uint32_t dim, uint64_t key) {
+	uint32_t counter0 = static_cast<uint32_t>(index);
+	uint32_t counter1 = static_cast<uint32_t>(index >> 32);
+	uint32_t counter2 = dim;
+	uint32_t counter3 = 0;
+	uint32_t key0 = static_cast<uint32_t>(key);
+	uint32_t key1 = static_cast<uint32_t>(key >> 32);
+	for (int round = 0; round < 10; round++) {
+		uint64_t product0 = static_cast<uint64_t>(0xD2511F53u) * counter0;
+		uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57u) * counter2;
+		counter0 = static_cast<uint32_t>(product1 >> 32) ^ counter1 ^ key0;
+		counter1 = static_cast<uint32_t>(product1);
+		counter2 = static_cast<uint32_t>(product0 >> 32) ^ counter3 ^ key1;
+		counter3 = static_cast<uint32_t>(product0);
+		key0 += 0x9E3779B9u;
+		key1 += 0xBB67AE85u;
+	}
+
+	return counter0;
+}
+
+// Dimension layout of a path sample: camera and lens come first, then a fixed block for each of the
+// first SobolBounces path vertices. Deeper vertices and overflowing blocks get hashed dimensions.
+constexpr int CameraDimensions = 4;
+constexpr int BounceDimensions = 16;
+constexpr int SobolBounces = 16;
+constexpr int FallbackDimension = 1 << 20;
 
 enum SamplerType {
 	IndependentSampler,
-	SimpleSobolSampler
+	SimpleSobolSampler,
+	OwenSobolSampler,
+	BlueNoiseSampler
 };
 
 struct SamplerParams {
@@ -42,36 +84,82 @@ public:
 		return ret;
 	}
 
+	// Copy with its own mutable state, every render thread works on a clone of the integrator's sampler
+	virtual std::shared_ptr<Sampler> Clone() const = 0;
+
+	// Per-pixel state only depends on the pixel, the sample index and the seed
 	virtual void SetPixel(int x, int y) = 0;
 
 	virtual void NextSample() = 0;
 
 	virtual void NextSamples(size_t samples) = 0;
 
+	// Jump to an absolute sample index, call before SetPixel
+	virtual void SetSampleIndex(uint64_t i) = 0;
+
+	inline uint64_t GetSampleIndex() const {
+		return index;
+	}
+
+	// Following values belong to path vertex depth (every segment, medium boundaries included)
+	inline void StartBounce(int depth) {
+		if (depth < SobolBounces) {
+			dim = CameraDimensions + depth * BounceDimensions;
+			dimEnd = dim + BounceDimensions;
+		}
+		else {
+			dim = dimEnd = 0;
+		}
+		fallbackDim = FallbackDimension + (depth + 1) * BounceDimensions;
+	}
+
 	inline SamplerType GetType() const {
 		return m_type;
 	}
 
 	static std::shared_ptr<Sampler> Create(const SamplerParams& params);
 
+protected:
+	// Dimension of the next value, a hashed dimension once the current block is used up
+	inline int NextDimension() {
+		return dim < dimEnd ? dim++ : fallbackDim++;
+	}
+
+	// Back to the camera block, at the start of every pixel sample
+	inline void ResetDimensions() {
+		dim = 0;
+		dimEnd = CameraDimensions;
+		fallbackDim = FallbackDimension;
+	}
+
 protected:
 	SamplerType m_type;
+	uint64_t index = 0;
+	int dim = 0;
+	int dimEnd = CameraDimensions;
+	int fallbackDim = FallbackDimension;
 };
 
 class Independent : public Sampler {
 public:
-	Independent();
+	Independent(uint32_t seed = 0);
 
 	virtual float Get1() override;
 
+	virtual std::shared_ptr<Sampler> Clone() const override;
+
 	virtual void SetPixel(int x, int y) override;
 
 	virtual void NextSample() override;
 
 	virtual void NextSamples(size_t samples) override;
 
+	virtual void SetSampleIndex(uint64_t i) override;
+
 private:
-	std::mt19937 rng;
+	// Every value is keyed by (pixel, sample index, dimension), see Philox4x32
+	uint32_t seed = 0;
+	uint64_t pixelKey = 0;
 };
 
 class SimpleSobol : public Sampler {
@@ -80,16 +168,84 @@ public:
 
 	virtual float Get1() override;
 
+	virtual std::shared_ptr<Sampler> Clone() const override;
+
 	virtual void SetPixel(int x, int y) override;
 
 	virtual void NextSample() override;
 
 	virtual void NextSamples(size_t samples) override;
 
+	virtual void SetSampleIndex(uint64_t i) override;
+
 private:
-	uint64_t index = 0;
-	int dim = 0;
 	uint32_t seed = 0;
 	uint32_t scramble = 0;
-	std::mt19937 rng;
+	uint64_t pixelKey = 0;// of the hashed dimensions
+};
+
+// Sobol sequence with hashed Owen scrambling, consecutive sample indices are walked in Gray-code order
+class OwenSobol : public Sampler {
+public:
+	OwenSobol(uint32_t seed);
+
+	virtual float Get1() override;
+
+	virtual Point2f Get2() override;
+
+	virtual Point3f Get3() override;
+
+	virtual Point4f Get4() override;
+
+	virtual std::shared_ptr<Sampler> Clone() const override;
+
+	virtual void SetPixel(int x, int y) override;
+
+	virtual void NextSample() override;
+
+	virtual void NextSamples(size_t samples) override;
+
+	virtual void SetSampleIndex(uint64_t i) override;
+
+private:
+	// Scrambled values of the next n dimensions
+	void GetN(float* values, int n);
+
+	// Unscrambled Sobol values of dimensions [0, dims), cached per sample index
+	const uint32_t* SobolValues(int dims);
+
+	// Scramble seeds of dimensions [0, dims), cached per pixel
+	const uint32_t* ScrambleSeeds(int dims);
+
+private:
+	uint32_t seed = 0;
+	uint64_t pixelKey = 0;
+	uint64_t cachedIndex = 0;
+	int cachedDims = 0;
+	int seededDims = 0;
+	std::vector<uint32_t> sobol;
+	std::vector<uint32_t> seeds;
+};
+
+// Rank-1 lattice (Kronecker) points, shifted per pixel by a tiled blue-noise mask, so the error of
+// low sample counts is spread as blue noise over neighbouring pixels
+class BlueNoise : public Sampler {
+public:
+	BlueNoise(uint32_t seed);
+
+	virtual float Get1() override;
+
+	virtual std::shared_ptr<Sampler> Clone() const override;
+
+	virtual void SetPixel(int x, int y) override;
+
+	virtual void NextSample() override;
+
+	virtual void NextSamples(size_t samples) override;
+
+	virtual void SetSampleIndex(uint64_t i) override;
+
+private:
+	int px = 0, py = 0;
+	uint32_t seed = 0;
 };
\ No newline at end of file
@@ -1,16 +1,89 @@
 #include "Scene.h"
 
-Scene::Scene(const RTCDevice& device) {
+// Intersection context of a boundary traversal, Embree hands it to the filter callback
+struct BoundaryContext {
+	RTCIntersectContext context;// first member, the callback casts the context pointer back
+	const Scene* scene;
+	int count;
+	float t[MaxBoundaryHits];
+	RTCHit hits[MaxBoundaryHits];
+};
+
+// Medium boundaries are recorded and rejected so the traversal goes on, any other surface is accepted
+static void BoundaryFilterFunc(const RTCFilterFunctionNArguments* args) {
+	BoundaryContext* boundaryContext = (BoundaryContext*)args->context;
+	for (unsigned int i = 0; i < args->N; i++) {
+		if (args->valid[i] != -1) {
+			continue;
+		}
+
+		unsigned int instID = RTCHitN_instID(args->hit, args->N, i, 0);
+		int id = instID != RTC_INVALID_GEOMETRY_ID ? instID : RTCHitN_geomID(args->hit, args->N, i);
+		if (!boundaryContext->scene->HasShapeFlag(id, ShapeFlags::MediumBoundaryShape)) {
+			continue;
+		}
+
+		// A full record lets the boundary end the traversal
+		if (boundaryContext->count < MaxBoundaryHits) {
+			boundaryContext->t[boundaryContext->count] = RTCRayN_tfar(args->ray, args->N, i);
+			boundaryContext->hits[boundaryContext->count] = rtcGetHitFromHitN(args->hit, args->N, i);
+			boundaryContext->count++;
+			args->valid[i] = 0;
+		}
+	}
+}
+
+Scene::Scene(const EmbreeParams& params) {
 	infiniteLight = NULL;
+	infiniteLightID = -1;
+	environmentProbability = 0.0f;
+	cameraMediumID = -1;
+	hasMedia = false;
+	hasMediumBoundary = false;
+	memoryBytes = 0;
+	peakMemoryBytes = 0;
 
 	// Creating a new device
-	rtc_device = device;
+	std::string config;
+	if (params.threads > 0) {
+		config += "threads=" + std::to_string(params.threads) + ",";
+	}
+	if (!params.isa.empty()) {
+		config += "isa=" + params.isa + ",";
+	}
+	rtc_device = rtcNewDevice(config.c_str());
+	buildStats.isa = params.isa.empty() ? "default" : params.isa;
+	if (rtc_device == NULL) {
+		printf("Embree device with \"%s\" failed, using the default device\n", config.c_str());
+		rtc_device = rtcNewDevice(NULL);
+		buildStats.isa = "default";
+	}
+	rtcSetDeviceMemoryMonitorFunction(rtc_device, MemoryMonitorFunc, this);
+
+	// Embree does not report the ISA it picked, only the packet widths its kernels trace natively
+	if (rtcGetDeviceProperty(rtc_device, RTC_DEVICE_PROPERTY_NATIVE_RAY16_SUPPORTED)) {
+		buildStats.nativePacketWidth = 16;
+	}
+	else if (rtcGetDeviceProperty(rtc_device, RTC_DEVICE_PROPERTY_NATIVE_RAY8_SUPPORTED)) {
+		buildStats.nativePacketWidth = 8;
+	}
+	else {
+		buildStats.nativePacketWidth = 4;
+	}
 
 	// Creating a new scene
 	rtc_scene = rtcNewScene(rtc_device);
-	rtcSetSceneFlags(rtc_scene, RTC_SCENE_FLAG_COMPACT | RTC_SCENE_FLAG_ROBUST);
+	int flags = RTC_SCENE_FLAG_NONE;
+	if (params.compact) {
+		flags |= RTC_SCENE_FLAG_COMPACT;
+	}
+	if (params.robust) {
+		flags |= RTC_SCENE_FLAG_ROBUST;
+	}
+	rtcSetSceneFlags(rtc_scene, (RTCSceneFlags)flags);
 
-	rtcInitIntersectContext(&context);
+	const RTCBuildQuality qualities[] = { RTC_BUILD_QUALITY_LOW, RTC_BUILD_QUALITY_MEDIUM, RTC_BUILD_QUALITY_HIGH };
+	rtcSetSceneBuildQuality(rtc_scene, qualities[params.quality]);
 }
 
 Scene::~Scene() {
@@ -28,7 +101,6 @@ void Scene::AddLight(std::shared_ptr<Light> light) {
 	}
 	else {
 		shapes.push_back(light->GetShape());
-		shapeToLight.insert({ light->GetShape()->GetGeometryID(), lights.size() });
 	}
 	lights.push_back(light);
 }
@@ -37,43 +109,168 @@ void Scene::SetCamera(std::shared_ptr<Camera> c) {
 	camera = c;
 }
 
-std::shared_ptr<Camera> Scene::GetCamera() const {
+const std::shared_ptr<Camera>& Scene::GetCamera() const {
 	return camera;
 }
 
 void Scene::Commit() {
-	std::vector<float> power(lights.size());
+	auto t1 = std::chrono::steady_clock::now();
+	peakMemoryBytes = memoryBytes.load();
+
+	// Area lights go into the light BVH, the environment is chosen as often as the whole BVH
+	lightBVH = LightBVH(lights);
+	infiniteLightID = -1;
 	for (int i = 0; i < lights.size(); i++) {
-		auto light = lights[i];
-		float pdf = light->LightLuminance();
-		power[i] = pdf;
+		if (lights[i] == infiniteLight) {
+			infiniteLightID = i;
+		}
 	}
-	lightTable = AliasTable1D(power);
+	environmentProbability = infiniteLight == NULL ? 0.0f : (lightBVH.Empty() ? 1.0f : 0.5f);
 
-	// Constructing Embree objects, setting VBOs/IBOs
+	materials.clear();
+	media.clear();
+	materialIDs.clear();
+	mediumIDs.clear();
+	shapeRecords.resize(shapes.size());
 	for (int i = 0; i < shapes.size(); i++) {
-		shapes[i]->ConstructEmbreeObject(rtc_device, rtc_scene);
+		auto material = shapes[i]->GetMaterial();
+		ShapeRecord& record = shapeRecords[i];
+		record.materialID = RegisterMaterial(material);
+		record.inMediumID = RegisterMedium(shapes[i]->GetInMedium());
+		record.outMediumID = RegisterMedium(shapes[i]->GetOutMedium());
+		record.lightID = -1;
+		record.flags = 0;
+		if (material != NULL && material->GetType() == MaterialType::DiffuseLightMaterial) {
+			record.flags |= ShapeFlags::EmissiveShape;
+		}
+		if (material != NULL && material->GetType() == MaterialType::MediumBoundaryMaterial) {
+			record.flags |= ShapeFlags::MediumBoundaryShape;
+		}
+	}
+	cameraMediumID = camera == NULL ? -1 : RegisterMedium(camera->GetMedium());
+
+	hasMediumBoundary = false;
+	hasMedia = cameraMediumID >= 0;
+	for (const auto& record : shapeRecords) {
+		if (record.flags & ShapeFlags::MediumBoundaryShape) {
+			hasMediumBoundary = true;
+		}
+		if (record.inMediumID >= 0 || record.outMediumID >= 0 || hasMediumBoundary) {
+			hasMedia = true;
+		}
+	}
+
+	// Boundary traversals filter every hit through the intersection context, instanced prototypes inherit the flag
+	if (hasMediumBoundary) {
+		rtcSetSceneFlags(rtc_scene, (RTCSceneFlags)(rtcGetSceneFlags(rtc_scene) | RTC_SCENE_FLAG_CONTEXT_FILTER_FUNCTION));
+	}
+
+	// Constructing Embree objects, setting VBOs/IBOs.
+	// Shapes keep their index as geometry ID so hits index the records directly, the spheres share the ID after the last shape
+	spherePrimitives.clear();
+	for (int i = 0; i < shapes.size(); i++) {
+		shapes[i]->SetGeometryID(i);
+		if (shapes[i]->GetType() == ShapeType::SphereShape) {
+			spherePrimitives.push_back(static_cast<Sphere*>(shapes[i])->GetPrimitive());
+		}
+		else {
+			shapes[i]->ConstructEmbreeObject(rtc_device, rtc_scene);
+		}
+	}
+	if (!spherePrimitives.empty()) {
+		Sphere::ConstructEmbreeBatch(rtc_device, rtc_scene, spherePrimitives, shapes.size());
 	}
 
-	// Loading the scene
+	// Geometry IDs are only known once the shapes are attached
+	for (int i = 0; i < lights.size(); i++) {
+		if (lights[i]->GetType() != LightType::InfiniteAreaLight) {
+			shapeRecords[lights[i]->GetShape()->GetGeometryID()].lightID = i;
+		}
+	}
+
+	// Loading the scene, the only commit builds the BVH over every geometry at once
 	rtcCommitScene(rtc_scene);
+
+	buildStats.commitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+	buildStats.memoryBytes = memoryBytes;
+	buildStats.peakMemoryBytes = peakMemoryBytes;
+
+	std::ostringstream log;
+	log << "Commit " << shapes.size() << " shapes in " << buildStats.commitSeconds * 1000.0 << " ms, Embree memory "
+		<< buildStats.memoryBytes / 1024 << " KB (peak " << buildStats.peakMemoryBytes / 1024 << " KB), isa " << buildStats.isa
+		<< ", native packet width " << buildStats.nativePacketWidth << "\n";
+	std::cout << log.str();
+}
+
+bool Scene::MemoryMonitorFunc(void* ptr, ssize_t bytes, bool post) {
+	Scene* scene = (Scene*)ptr;
+	int64_t current = scene->memoryBytes.fetch_add(bytes) + bytes;
+	int64_t peak = scene->peakMemoryBytes.load();
+	while (current > peak && !scene->peakMemoryBytes.compare_exchange_weak(peak, current)) {
+	}
+
+	return true;
+}
+
+int Scene::RegisterMaterial(std::shared_ptr<Material> material) {
+	if (material == NULL) {
+		return -1;
+	}
+
+	auto found = materialIDs.find(material.get());
+	if (found != materialIDs.end()) {
+		return found->second;
+	}
+	int id = materials.size();
+	materials.push_back(material);
+	materialIDs.emplace(material.get(), id);
+
+	return id;
+}
+
+int Scene::RegisterMedium(std::shared_ptr<Medium> medium) {
+	if (medium == NULL) {
+		return -1;
+	}
+
+	auto found = mediumIDs.find(medium.get());
+	if (found != mediumIDs.end()) {
+		return found->second;
+	}
+	int id = media.size();
+	media.push_back(medium);
+	mediumIDs.emplace(medium.get(), id);
+
+	return id;
 }
 
+// Every query gets its own context, Embree keeps the instance stack of a traversal in it
 void Scene::Intersect(RTCRayHit& rayhit) {
+	RTCIntersectContext context;
+	rtcInitIntersectContext(&context);
 	rtcIntersect1(rtc_scene, &context, &rayhit);
 }
 
 void Scene::ClosestHit(const RTCRayHit& rayhit, IntersectionInfo& info) {
-	int id = rayhit.hit.geomID;
+	// Hits inside an instance report the instance as instID and the prototype geometry as geomID
+	bool instanced = rayhit.hit.instID[0] != RTC_INVALID_GEOMETRY_ID;
+	int id = instanced ? rayhit.hit.instID[0] : rayhit.hit.geomID;
 	Vector3f dir = GetRayDir(rayhit);
 
-	if (shapes[id]->GetType() == ShapeType::TriangleMeshShape) {
+	ShapeType type = shapes[id]->GetType();
+	if (type == ShapeType::TriangleMeshShape || type == ShapeType::InstanceShape) {
 		Shape* shape = shapes[id];
 		info.uv = shape->GetTexcoords(rayhit.hit.primID, Point2f(rayhit.hit.u, rayhit.hit.v));
 		Vector3f Ns = shape->GetShadeNormal(rayhit.hit.primID, Point2f(rayhit.hit.u, rayhit.hit.v));
 		Vector3f Ng = shape->GetGeometryNormal(rayhit.hit.primID);
 		info.SetNormal(dir, Ng, Ns);
 	}
+	else if (type == ShapeType::SphereShape) {
+		// The sphere callbacks leave the UV to the closest hit
+		info.uv = static_cast<Sphere*>(shapes[id])->GetUV(GetHitPos(rayhit));
+		Vector3f N = Vector3f(rayhit.hit.Ng_x, rayhit.hit.Ng_y, rayhit.hit.Ng_z);
+		info.SetNormal(dir, N, N);
+	}
 	else {
 		info.uv = Point2f(rayhit.hit.u, rayhit.hit.v);
 		Vector3f N = glm::normalize(Vector3f(rayhit.hit.Ng_x, rayhit.hit.Ng_y, rayhit.hit.Ng_z));
@@ -82,10 +279,13 @@ void Scene::ClosestHit(const RTCRayHit& rayhit, IntersectionInfo& info) {
 
 	info.t = rayhit.ray.tfar;
 	info.position = GetHitPos(rayhit);
-	info.material = shapes[id]->GetMaterial();
 	info.geomID = id;
 	info.primID = rayhit.hit.primID;
-	info.mi = MediumInterface(shapes[id]->GetInMedium(), shapes[id]->GetOutMedium());
+	info.instID = instanced ? id : -1;
+	const ShapeRecord& record = shapeRecords[id];
+	info.materialID = record.materialID;
+	info.inMediumID = record.inMediumID;
+	info.outMediumID = record.outMediumID;
 }
 
 void Scene::Miss(const RTCRayHit& rayhit, IntersectionInfo& info) {
@@ -95,10 +295,12 @@ void Scene::Miss(const RTCRayHit& rayhit, IntersectionInfo& info) {
 	info.Ns = Vector3f(0.0f);
 	info.position = Point3f(Infinity);
 	info.uv = Point2f(0.0f);
-	info.material = NULL;
 	info.geomID = -1;
 	info.primID = -1;
-	info.mi = MediumInterface(camera->GetMedium());
+	info.instID = -1;
+	info.materialID = -1;
+	info.inMediumID = cameraMediumID;
+	info.outMediumID = cameraMediumID;
 }
 
 void Scene::TraceRay(RTCRayHit& rayhit, IntersectionInfo& info) {
@@ -111,85 +313,244 @@ void Scene::TraceRay(RTCRayHit& rayhit, IntersectionInfo& info) {
 	}
 }
 
-Spectrum Scene::SampleLightEnvironment(const Spectrum& history, Vector3f& L, float& pdf, float& mult_trans_pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler) {
-	if (lights.size() == 0) {
+void Scene::TraceRayThroughBoundaries(RTCRayHit& rayhit, BoundaryTrace& trace) {
+	BoundaryContext boundaryContext;
+	rtcInitIntersectContext(&boundaryContext.context);
+	boundaryContext.context.filter = BoundaryFilterFunc;
+	boundaryContext.scene = this;
+	boundaryContext.count = 0;
+	rtcIntersect1(rtc_scene, &boundaryContext.context, &rayhit);
+
+	// Boundaries come in traversal order, those behind the final hit were recorded before it was found
+	int order[MaxBoundaryHits];
+	int count = 0;
+	for (int k = 0; k < boundaryContext.count; k++) {
+		if (boundaryContext.t[k] >= rayhit.ray.tfar) {
+			continue;
+		}
+
+		int j = count++;
+		while (j > 0 && boundaryContext.t[order[j - 1]] > boundaryContext.t[k]) {
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = k;
+	}
+
+	trace.count = 0;
+	trace.next = 0;
+	RTCRayHit boundaryHit = rayhit;
+	float pre_t = 0.0f;
+	for (int k = 0; k < count; k++) {
+		const RTCHit& hit = boundaryContext.hits[order[k]];
+		float t = boundaryContext.t[order[k]];
+
+		// A primitive in overlapping BVH leaves may be reported twice
+		if (k > 0) {
+			const RTCHit& last = boundaryContext.hits[order[k - 1]];
+			if (t == boundaryContext.t[order[k - 1]] && hit.geomID == last.geomID && hit.primID == last.primID && hit.instID[0] == last.instID[0]) {
+				continue;
+			}
+		}
+
+		boundaryHit.ray.tfar = t;
+		boundaryHit.hit = hit;
+		IntersectionInfo& info = trace.hits[trace.count++];
+		ClosestHit(boundaryHit, info);
+		info.t = t - pre_t;
+		pre_t = t;
+	}
+
+	IntersectionInfo& info = trace.hits[trace.count++];
+	if (rayhit.hit.geomID != RTC_INVALID_GEOMETRY_ID) {
+		ClosestHit(rayhit, info);
+		info.t -= pre_t;
+	}
+	else {
+		Miss(rayhit, info);
+	}
+}
+
+void Scene::TraceRays(RTCRayHit* rayhits, IntersectionInfo* infos, int count, bool coherent) {
+	RTCIntersectContext context;
+	rtcInitIntersectContext(&context);
+	if (coherent) {
+		context.flags = RTC_INTERSECT_CONTEXT_FLAG_COHERENT;
+	}
+	rtcIntersect1M(rtc_scene, &context, rayhits, count, sizeof(RTCRayHit));
+	for (int i = 0; i < count; i++) {
+		if (rayhits[i].hit.geomID != RTC_INVALID_GEOMETRY_ID) {
+			ClosestHit(rayhits[i], infos[i]);
+		}
+		else {
+			Miss(rayhits[i], infos[i]);
+		}
+	}
+}
+
+bool Scene::Occluded(RTCRay& ray) {
+	RTCIntersectContext context;
+	rtcInitIntersectContext(&context);
+	rtcOccluded1(rtc_scene, &context, &ray);
+
+	return ray.tfar < 0.0f;
+}
+
+void Scene::OccludedRays(RTCRay* rays, int count) {
+	RTCIntersectContext context;
+	rtcInitIntersectContext(&context);
+	rtcOccluded1M(rtc_scene, &context, rays, count, sizeof(RTCRay));
+}
+
+void Scene::TracePacket(RTCRayHit8& packet, const int* valid, IntersectionInfo* infos) {
+	RTCIntersectContext context;
+	rtcInitIntersectContext(&context);
+	context.flags = RTC_INTERSECT_CONTEXT_FLAG_COHERENT;
+	rtcIntersect8(valid, rtc_scene, &context, &packet);
+	for (int i = 0; i < PacketSize; i++) {
+		if (valid[i] == 0) {
+			continue;
+		}
+
+		RTCRayHit rayhit = GetRayHit(packet, i);
+		if (rayhit.hit.geomID != RTC_INVALID_GEOMETRY_ID) {
+			ClosestHit(rayhit, infos[i]);
+		}
+		else {
+			Miss(rayhit, infos[i]);
+		}
+	}
+}
+
+int Scene::ChooseLight(const IntersectionInfo& info, float u, float& pmf) const {
+	if (u < environmentProbability) {
+		pmf = environmentProbability;
+
+		return infiniteLightID;
+	}
+
+	u = std::min((u - environmentProbability) / (1.0f - environmentProbability), FloatOneMinusEpsilon);
+	int index = lightBVH.Sample(info.position, info.Ns, u, pmf);
+	pmf *= 1.0f - environmentProbability;
+
+	return index;
+}
+
+Spectrum Scene::SampleLight(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler) {
+	float pmf = 0.0f;
+	int index = ChooseLight(info, sampler.Get1(), pmf);
+	if (index < 0) {
 		pdf = 0.0f;
 
 		return Spectrum(0.0f);
 	}
 
-	int index = lightTable.Sample(sampler->Get2());
 	auto light = lights[index];
-	float dist = 0.0f;
 	Spectrum radiance = light->Sample(L, pdf, dist, info, sampler);
-	pdf *= (light->LightLuminance() / lightTable.Sum());
+	pdf *= pmf;
 
-	mult_trans_pdf = 1.0f;
-	Spectrum shadow_history(1.0f);
-	IntersectionInfo shadowInfo = info;
-	while (true) {
-		Ray shadowRay(shadowInfo.position, L);
-		RTCRayHit rtc_shadowRayHit = MakeRayHit(shadowRay.GetOrg(), shadowRay.GetDir(), Epsilon, dist - Epsilon);
-		TraceRay(rtc_shadowRayHit, shadowInfo);
-		if (rtc_shadowRayHit.hit.geomID != RTC_INVALID_GEOMETRY_ID) {
-			if (shadowInfo.material->GetType() != MaterialType::MediumBoundaryMaterial) {
-				return Spectrum(0.0f);
-			}
+	return radiance;
+}
 
-			auto medium = info.mi.GetMedium(shadowInfo.frontFace);
-			if (medium != NULL) {
-				float trans_pdf = 0.0f;
-				Spectrum transmittance = medium->EvaluateDistance(history * shadow_history, false, shadowInfo.t, trans_pdf);
+Spectrum Scene::SampleLightEnvironment(const Spectrum& history, Vector3f& L, float& pdf, float& mult_trans_pdf, const IntersectionInfo& info, Sampler& sampler) {
+	float pmf = 0.0f;
+	int index = ChooseLight(info, sampler.Get1(), pmf);
+	if (index < 0) {
+		pdf = 0.0f;
 
-				if (std::isnan(trans_pdf) || trans_pdf == 0.0f) {
-					return Spectrum(0.0f);
-				}
+		return Spectrum(0.0f);
+	}
 
-				shadow_history *= (transmittance / trans_pdf);
-				mult_trans_pdf *= trans_pdf;
-			}
-			dist -= shadowInfo.t;
+	auto light = lights[index];
+	float dist = 0.0f;
+	Spectrum radiance = light->Sample(L, pdf, dist, info, sampler);
+	pdf *= pmf;
+
+	mult_trans_pdf = 1.0f;
+	Spectrum shadow_history(1.0f);
+	if (!hasMediumBoundary) {
+		// Any blocker ends the shadow ray, an any-hit query is enough
+		RTCRay rtc_shadowRay = MakeRay(info.position, L, Epsilon, dist - Epsilon, RayVisibility::ShadowVisibility);
+		if (Occluded(rtc_shadowRay)) {
+			return Spectrum(0.0f);
 		}
-		else {// Hit light, get light medium
-			bool isEnv = light->GetType() == LightType::InfiniteAreaLight;
-			auto medium = isEnv ? camera->GetMedium() : light->GetShape()->GetOutMedium();
-			if (medium != NULL) {
-				float trans_pdf = 0.0f;
-				Spectrum transmittance = medium->EvaluateDistance(history * shadow_history, false, dist, trans_pdf);
+	}
+	else {
+		// Walk through the medium boundaries on the way, accumulating their transmittance.
+		// One traversal covers MaxBoundaryHits boundaries, only longer chains trace again from the last one.
+		BoundaryTrace trace;
+		Point3f origin = info.position;
+		bool reached = false;
+		while (!reached) {
+			RTCRayHit rtc_shadowRayHit = MakeRayHit(origin, L, Epsilon, dist - Epsilon, RayVisibility::ShadowVisibility);
+			TraceRayThroughBoundaries(rtc_shadowRayHit, trace);
+			for (int k = 0; k < trace.count; k++) {
+				const IntersectionInfo& shadowInfo = trace.hits[k];
+				if (shadowInfo.geomID < 0) {
+					reached = true;
+
+					break;
+				}
 
-				if (std::isnan(trans_pdf) || trans_pdf == 0.0f) {
+				if (!HasShapeFlag(shadowInfo.geomID, ShapeFlags::MediumBoundaryShape)) {
 					return Spectrum(0.0f);
 				}
 
-				shadow_history *= (transmittance / trans_pdf);
-				mult_trans_pdf *= trans_pdf;
-			}
+				// The medium on the side the shadow ray comes from
+				Medium* medium = GetMedium(shadowInfo.GetMediumID(shadowInfo.frontFace));
+				if (medium != NULL) {
+					float trans_pdf = 0.0f;
+					Spectrum transmittance = medium->EvaluateDistance(history * shadow_history, false, shadowInfo.t, trans_pdf);
 
-			if (shadow_history.HasNaNs()) {
-				return Spectrum(0.0f);
+					if (std::isnan(trans_pdf) || trans_pdf == 0.0f) {
+						return Spectrum(0.0f);
+					}
+
+					shadow_history *= (transmittance / trans_pdf);
+					mult_trans_pdf *= trans_pdf;
+				}
+				dist -= shadowInfo.t;
+				origin = shadowInfo.position;
 			}
+		}
+	}
 
-			radiance *= shadow_history;
+	// Reached the light, get light medium
+	bool isEnv = light->GetType() == LightType::InfiniteAreaLight;
+	Medium* medium = GetMedium(isEnv ? cameraMediumID : shapeRecords[light->GetShape()->GetGeometryID()].outMediumID);
+	if (medium != NULL) {
+		float trans_pdf = 0.0f;
+		Spectrum transmittance = medium->EvaluateDistance(history * shadow_history, false, dist, trans_pdf);
 
-			break;
+		if (std::isnan(trans_pdf) || trans_pdf == 0.0f) {
+			return Spectrum(0.0f);
 		}
+
+		shadow_history *= (transmittance / trans_pdf);
+		mult_trans_pdf *= trans_pdf;
+	}
+
+	if (shadow_history.HasNaNs()) {
+		return Spectrum(0.0f);
 	}
 
+	radiance *= shadow_history;
+
 	return radiance;
 }
 
-Spectrum Scene::EvaluateLight(int geomID, const Vector3f& L, float& pdf, const IntersectionInfo& info) {
-	int lightSize = infiniteLight == NULL ? lights.size() : lights.size() - 1;
-	if (lightSize == 0) {
+Spectrum Scene::EvaluateLight(int geomID, const Vector3f& L, float& pdf, const IntersectionInfo& info, const Point3f& pre_position, const Vector3f& pre_normal) {
+	// Emissive shapes that were not added as lights contribute nothing
+	int index = geomID < 0 ? -1 : shapeRecords[geomID].lightID;
+	if (index < 0) {
 		pdf = 0.0f;
 
 		return Spectrum(0.0f);
 	}
 
-	int index = shapeToLight[geomID];
-	auto light = lights[index];
+	const auto& light = lights[index];
 	Spectrum radiance = light->Evaluate(L, pdf, info);
-	pdf *= (light->LightLuminance() / lightTable.Sum());
+	pdf *= (1.0f - environmentProbability) * lightBVH.PMF(pre_position, pre_normal, index);
 
 	return radiance;
 }
@@ -202,7 +563,7 @@ Spectrum Scene::EvaluateEnvironment(const Vector3f& L, float& pdf) {
 	}
 
 	Spectrum radiance = infiniteLight->EvaluateEnvironment(L, pdf);
-	pdf *= (infiniteLight->LightLuminance() / lightTable.Sum());
+	pdf *= environmentProbability;
 
 	return radiance;
 }
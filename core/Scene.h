@@ -4,11 +4,61 @@
 #include "Shape.h"
 #include "Camera.h"
 #include "Light.h"
+#include "LightBVH.h"
 #include "Medium.h"
 
+enum BuildQualityType {
+	LowBuildQuality,
+	MediumBuildQuality,
+	HighBuildQuality
+};
+
+// Embree device and BVH build settings, trading build time and memory for traversal speed
+struct EmbreeParams {
+	BuildQualityType quality = BuildQualityType::MediumBuildQuality;
+	bool compact = true;// smaller BVH, slightly slower traversal
+	bool robust = true;// watertight traversal, slightly slower
+	int threads = 0;// Embree build threads, 0 for every hardware thread
+	std::string isa;// kernels to use, e.g. "sse4.2", "avx2" or "avx512", empty for the best the CPU supports
+};
+
+// Filled by Scene::Commit
+struct BuildStats {
+	double commitSeconds = 0.0;
+	int64_t memoryBytes = 0;// held by the device once the BVH is built
+	int64_t peakMemoryBytes = 0;
+	std::string isa;// isa= of the device config, "default" when Embree picked the kernels itself
+	int nativePacketWidth = 4;// widest ray packet the device traces natively, 4, 8 or 16
+};
+
+enum ShapeFlags {
+	EmissiveShape = 1 << 0,
+	MediumBoundaryShape = 1 << 1,
+};
+
+// Per-geometry record built on Commit and only read while rendering, indexed by geomID
+struct ShapeRecord {
+	int materialID;// index into the material table, -1 for none
+	int inMediumID;
+	int outMediumID;
+	int lightID;// index into the light list, -1 if the shape is not a light
+	uint32_t flags;// ShapeFlags
+};
+
+constexpr int MaxBoundaryHits = 16;
+
+// Hits of one traversal in ray order: the medium boundaries it passed, then the surface that stopped it or a miss.
+// Each t is measured from the previous hit, so consecutive hits bound one medium segment.
+struct BoundaryTrace {
+	IntersectionInfo hits[MaxBoundaryHits + 1];
+	int count = 0;
+	int next = 0;// first hit the path has not crossed yet
+};
+
 class Scene {
 public:
-	Scene(const RTCDevice& device);
+	// The scene owns its Embree device
+	Scene(const EmbreeParams& params = EmbreeParams());
 
 	~Scene();
 
@@ -18,15 +68,66 @@ public:
 
 	void SetCamera(std::shared_ptr<Camera> c);
 
-	std::shared_ptr<Camera> GetCamera() const;
+	const std::shared_ptr<Camera>& GetCamera() const;
 
 	void Commit();
 
+	inline const BuildStats& GetBuildStats() const {
+		return buildStats;
+	}
+
 	void TraceRay(RTCRayHit& rayhit, IntersectionInfo& info);
 
-	Spectrum SampleLightEnvironment(const Spectrum& history, Vector3f& L, float& pdf, float& mult_trans_pdf, const IntersectionInfo& info, std::shared_ptr<Sampler> sampler);
+	// Closest hit that is not a medium boundary, a filter callback records the boundaries in front of it in the same traversal.
+	// Past MaxBoundaryHits the traversal stops at the next boundary, which is then the last hit.
+	void TraceRayThroughBoundaries(RTCRayHit& rayhit, BoundaryTrace& trace);
+
+	// Stream queries, every ray of the batch is traced by a single Embree call
+	void TraceRays(RTCRayHit* rayhits, IntersectionInfo* infos, int count, bool coherent = false);
+
+	// Any-hit query, true if something blocks the ray
+	bool Occluded(RTCRay& ray);
+
+	void OccludedRays(RTCRay* rays, int count);
+
+	// Packet of coherent camera rays, lanes with valid[i] == 0 are skipped
+	void TracePacket(RTCRayHit8& packet, const int* valid, IntersectionInfo* infos);
+
+	// True if any medium or medium boundary is present, shadow rays then need the transmittance loop
+	inline bool HasMedia() const {
+		return hasMedia;
+	}
+
+	// Without medium boundaries shadow rays are plain occlusion queries
+	inline bool HasMediumBoundary() const {
+		return hasMediumBoundary;
+	}
+
+	// Hit records carry indices, materials and media are resolved here at shading time without reference counting
+	inline Material* GetMaterial(int materialID) const {
+		return materialID < 0 ? NULL : materials[materialID].get();
+	}
 
-	Spectrum EvaluateLight(int geomID, const Vector3f& L, float& pdf, const IntersectionInfo& info);
+	inline Medium* GetMedium(int mediumID) const {
+		return mediumID < 0 ? NULL : media[mediumID].get();
+	}
+
+	inline const ShapeRecord& GetShapeRecord(int geomID) const {
+		return shapeRecords[geomID];
+	}
+
+	// False for misses and medium scattering events, which carry geomID = -1
+	inline bool HasShapeFlag(int geomID, ShapeFlags flag) const {
+		return geomID >= 0 && (shapeRecords[geomID].flags & flag) != 0;
+	}
+
+	// Pick a light and a point on it, visibility is left to the caller
+	Spectrum SampleLight(Vector3f& L, float& pdf, float& dist, const IntersectionInfo& info, Sampler& sampler);
+
+	Spectrum SampleLightEnvironment(const Spectrum& history, Vector3f& L, float& pdf, float& mult_trans_pdf, const IntersectionInfo& info, Sampler& sampler);
+
+	// The light is chosen depending on the shading point, pre_position and pre_normal are those of the vertex the light was hit from
+	Spectrum EvaluateLight(int geomID, const Vector3f& L, float& pdf, const IntersectionInfo& info, const Point3f& pre_position, const Vector3f& pre_normal);
 
 	Spectrum EvaluateEnvironment(const Vector3f& L, float& pdf);
 
@@ -37,14 +138,38 @@ private:
 
 	void Miss(const RTCRayHit& rayhit, IntersectionInfo& info);
 
+	int RegisterMaterial(std::shared_ptr<Material> material);
+
+	int RegisterMedium(std::shared_ptr<Medium> medium);
+
+	// Index into lights by the light BVH, or the environment light, -1 if no light reaches the point
+	int ChooseLight(const IntersectionInfo& info, float u, float& pmf) const;
+
+	// Called by Embree for every allocation and release of the device
+	static bool MemoryMonitorFunc(void* ptr, ssize_t bytes, bool post);
+
 private:
 	RTCDevice rtc_device;
 	RTCScene rtc_scene;
-	RTCIntersectContext context;
 	std::vector<Shape*> shapes;
 	std::vector<std::shared_ptr<Light>> lights;
 	std::shared_ptr<Light> infiniteLight;
 	std::shared_ptr<Camera> camera;
-	std::map<int, int> shapeToLight;
-	AliasTable1D lightTable;
+	// Flat tables the hit records index into, built on Commit
+	std::vector<std::shared_ptr<Material>> materials;
+	std::vector<std::shared_ptr<Medium>> media;
+	std::unordered_map<const Material*, int> materialIDs;
+	std::unordered_map<const Medium*, int> mediumIDs;
+	std::vector<ShapeRecord> shapeRecords;
+	// Every sphere of the scene in one Embree geometry, read by its callbacks while rendering
+	std::vector<SpherePrimitive> spherePrimitives;
+	int cameraMediumID;
+	LightBVH lightBVH;
+	int infiniteLightID;
+	float environmentProbability;// chance of sampling the environment instead of the light BVH
+	bool hasMedia;
+	bool hasMediumBoundary;
+	BuildStats buildStats;
+	std::atomic<int64_t> memoryBytes;
+	std::atomic<int64_t> peakMemoryBytes;
 };
\ No newline at end of file
@@ -8,7 +8,6 @@ void SceneParser::LoadFromJson(const std::string& fn, bool& is_succeed) {
 		return;
 	}
 
-	RTCDevice rtc_device = rtcNewDevice(NULL);
-	scene = std::make_shared<Scene>(rtc_device);
+	scene = std::make_shared<Scene>();
 	Parse(data);
 }
\ No newline at end of file
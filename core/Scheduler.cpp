@@ -0,0 +1,155 @@
+#include "Scheduler.h"
+
+static uint32_t MortonCode2D(uint32_t x, uint32_t y) {
+	auto Part1By1 = [](uint32_t v) -> uint32_t {
+		v &= 0x0000ffff;
+		v = (v ^ (v << 8)) & 0x00ff00ff;
+		v = (v ^ (v << 4)) & 0x0f0f0f0f;
+		v = (v ^ (v << 2)) & 0x33333333;
+		v = (v ^ (v << 1)) & 0x55555555;
+
+		return v;
+	};
+
+	return (Part1By1(y) << 1) | Part1By1(x);
+}
+
+TileScheduler::TileScheduler(int size, TileOrderType order, int threads) :
+	m_order(order), tileSize(std::max(size, 1)), numThreads(threads > 0 ? threads : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1)),
+	imageWidth(0), imageHeight(0), queues(numThreads), stolen(0) {}
+
+void TileScheduler::GenerateTiles(int width, int height) {
+	imageWidth = width;
+	imageHeight = height;
+	tiles.clear();
+
+	int nx = (width + tileSize - 1) / tileSize;
+	int ny = (height + tileSize - 1) / tileSize;
+	std::vector<Point2i> grid;
+	for (int ty = 0; ty < ny; ty++) {
+		for (int tx = 0; tx < nx; tx++) {
+			grid.push_back(Point2i(tx, ty));
+		}
+	}
+
+	if (m_order == TileOrderType::MortonTileOrder) {
+		std::stable_sort(grid.begin(), grid.end(), [](const Point2i& a, const Point2i& b) {
+			return MortonCode2D(a.x, a.y) < MortonCode2D(b.x, b.y);
+		});
+	}
+	else if (m_order == TileOrderType::SpiralTileOrder) {
+		// Rings around the image center, each ring walked by angle
+		float cx = 0.5f * (nx - 1);
+		float cy = 0.5f * (ny - 1);
+		std::stable_sort(grid.begin(), grid.end(), [cx, cy](const Point2i& a, const Point2i& b) {
+			float ra = std::max(std::abs(a.x - cx), std::abs(a.y - cy));
+			float rb = std::max(std::abs(b.x - cx), std::abs(b.y - cy));
+			if (ra != rb) {
+				return ra < rb;
+			}
+
+			return std::atan2(a.y - cy, a.x - cx) < std::atan2(b.y - cy, b.x - cx);
+		});
+	}
+
+	for (const auto& g : grid) {
+		Tile tile;
+		tile.x0 = g.x * tileSize;
+		tile.y0 = g.y * tileSize;
+		tile.x1 = std::min(tile.x0 + tileSize, width);
+		tile.y1 = std::min(tile.y0 + tileSize, height);
+		tiles.push_back(tile);
+	}
+
+	tileCosts.assign(tiles.size(), 0.0);
+}
+
+bool TileScheduler::NextTile(int thread, int& index) {
+	{
+		TileQueue& own = queues[thread];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tiles.empty()) {
+			index = own.tiles.front();
+			own.tiles.pop_front();
+
+			return true;
+		}
+	}
+
+	// Own queue is empty, steal from the other threads
+	for (int k = 1; k < numThreads; k++) {
+		TileQueue& victim = queues[(thread + k) % numThreads];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tiles.empty()) {
+			index = victim.tiles.back();
+			victim.tiles.pop_back();
+			stolen++;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void TileScheduler::SetImageSize(int width, int height) {
+	if (width != imageWidth || height != imageHeight) {
+		GenerateTiles(width, height);
+	}
+}
+
+void TileScheduler::Run(int width, int height, const std::function<void(const Tile&, int)>& func) {
+	SetImageSize(width, height);
+
+	// Contiguous runs of the ordered tiles, so every thread starts on a compact region
+	int numTiles = tiles.size();
+	for (int t = 0; t < numThreads; t++) {
+		int begin = (long long)numTiles * t / numThreads;
+		int end = (long long)numTiles * (t + 1) / numThreads;
+		queues[t].tiles.clear();
+		for (int i = begin; i < end; i++) {
+			queues[t].tiles.push_back(i);
+		}
+	}
+	stolen = 0;
+
+#pragma omp parallel num_threads(numThreads)
+	{
+		int thread = omp_get_thread_num();
+		int index = 0;
+		while (NextTile(thread, index)) {
+			auto t1 = std::chrono::steady_clock::now();
+			func(tiles[index], thread);
+			auto t2 = std::chrono::steady_clock::now();
+			tileCosts[index] = std::chrono::duration<double>(t2 - t1).count();
+		}
+	}
+}
+
+void TileScheduler::ReportTileCosts() const {
+	if (tileCosts.size() == 0) {
+		return;
+	}
+
+	double sum = 0.0;
+	double minCost = tileCosts[0];
+	double maxCost = tileCosts[0];
+	int maxIndex = 0;
+	for (int i = 0; i < tileCosts.size(); i++) {
+		sum += tileCosts[i];
+		minCost = std::min(minCost, tileCosts[i]);
+		if (tileCosts[i] > maxCost) {
+			maxCost = tileCosts[i];
+			maxIndex = i;
+		}
+	}
+
+	const Tile& slowest = tiles[maxIndex];
+	std::cout << std::fixed << std::setprecision(3) << "Tiles: " << tiles.size() << "    Threads: " << numThreads << "    Stolen: " << stolen
+		<< "    Tile cost(ms) min/avg/max: " << minCost * 1000.0 << "/" << sum / tiles.size() * 1000.0 << "/" << maxCost * 1000.0
+		<< "    Slowest tile: (" << slowest.x0 << ", " << slowest.y0 << ")" << std::endl;
+}
+
+std::shared_ptr<TileScheduler> TileScheduler::Create(const TileSchedulerParams& params) {
+	return std::make_shared<TileScheduler>(params.tileSize, params.order, params.threads);
+}
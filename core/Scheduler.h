@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Utils.h"
+
+enum TileOrderType {
+	ScanlineTileOrder,
+	MortonTileOrder,
+	SpiralTileOrder
+};
+
+struct TileSchedulerParams {
+	int tileSize;
+	TileOrderType order;
+	int threads;
+};
+
+struct Tile {
+	int x0, y0;
+	int x1, y1;
+};
+
+class TileScheduler {
+public:
+	// threads = 0 uses every hardware thread of the machine
+	TileScheduler(int size = 16, TileOrderType order = TileOrderType::MortonTileOrder, int threads = 0);
+
+	inline int GetTileSize() const {
+		return tileSize;
+	}
+
+	inline int GetThreads() const {
+		return numThreads;
+	}
+
+	inline const std::vector<Tile>& GetTiles() const {
+		return tiles;
+	}
+
+	// Seconds spent on every tile during the last Run
+	inline const std::vector<double>& GetTileCosts() const {
+		return tileCosts;
+	}
+
+	// Regenerates the tiles when the image size changed, Run calls it as well
+	void SetImageSize(int width, int height);
+
+	// Execute func(tile, thread) once for every tile of a width x height image, tiles are balanced by work stealing
+	void Run(int width, int height, const std::function<void(const Tile&, int)>& func);
+
+	void ReportTileCosts() const;
+
+	static std::shared_ptr<TileScheduler> Create(const TileSchedulerParams& params);
+
+private:
+	void GenerateTiles(int width, int height);
+
+	bool NextTile(int thread, int& index);
+
+private:
+	// Per-thread deque, the owner pops from the front and thieves steal from the back
+	struct alignas(64) TileQueue {
+		std::mutex mutex;
+		std::deque<int> tiles;
+	};
+
+	TileOrderType m_order;
+	int tileSize;
+	int numThreads;
+	int imageWidth, imageHeight;
+	std::vector<Tile> tiles;
+	std::vector<double> tileCosts;
+	std::vector<TileQueue> queues;
+	std::atomic<int> stolen;
+};
@@ -2,8 +2,51 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
-TriangleMesh::TriangleMesh(std::shared_ptr<Material> m, const std::string& file, const Transform& trans, std::shared_ptr<Medium> out, std::shared_ptr<Medium> in) : 
+// OBJ indices of a face corner, corners with the same key share one vertex of the mesh
+struct VertexKey {
+	int vertex, normal, texcoord;
+
+	inline bool operator==(const VertexKey& k) const {
+		return vertex == k.vertex && normal == k.normal && texcoord == k.texcoord;
+	}
+};
+
+struct VertexKeyHash {
+	inline size_t operator()(const VertexKey& k) const {
+		uint64_t h = static_cast<uint32_t>(k.vertex);
+		h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(k.normal);
+		h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(k.texcoord);
+
+		return static_cast<size_t>(h ^ (h >> 29));
+	}
+};
+
+TriangleMesh::TriangleMesh(std::shared_ptr<Material> m, const std::string& file, const Transform& trans, std::shared_ptr<Medium> out, std::shared_ptr<Medium> in,
+	bool useBinary) : 
 	Shape(ShapeType::TriangleMeshShape, m, trans, out, in) {
+	std::filesystem::path path(file);
+	if (path.extension() == ".drm") {
+		if (!LoadBinary(file)) {
+			printf("LoadFromBinary %s failed!", file.c_str());
+			assert(0);
+		}
+
+		return;
+	}
+
+	// an OBJ converted by MeshConverter is read from its binary file next to it, unless the OBJ is newer
+	std::filesystem::path binary = path;
+	binary.replace_extension(".drm");
+	std::error_code ec;
+	if (useBinary && std::filesystem::exists(binary, ec) && std::filesystem::exists(path, ec) &&
+		std::filesystem::last_write_time(binary, ec) >= std::filesystem::last_write_time(path, ec) && LoadBinary(binary.string())) {
+		return;
+	}
+
+	LoadObj(file);
+}
+
+void TriangleMesh::LoadObj(const std::string& file) {
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
 	std::vector<tinyobj::material_t> materials;
@@ -15,6 +58,25 @@ TriangleMesh::TriangleMesh(std::shared_ptr<Material> m, const std::string& file,
 		assert(0);
 	}
 
+	// corners with identical attributes are welded into one indexed vertex
+	size_t faces = 0;
+	for (size_t s = 0; s < shapes.size(); ++s) {
+		faces += shapes[s].mesh.num_face_vertices.size();
+	}
+	this->vertices.reserve(attrib.vertices.size() + 1);
+	this->normals.reserve(attrib.vertices.size());
+	this->texcoords.reserve(attrib.vertices.size() / 3 * 2);
+	this->indices.reserve(3 * faces);
+
+	std::unordered_map<VertexKey, uint32_t, VertexKeyHash> welded;
+	welded.reserve(attrib.vertices.size() / 3);
+	int face = 0;
+
+	// under a mirroring transform the corners are emitted in swapped order, so the geometric normal
+	// of the transformed triangle stays on the side of the normals brought over by TransformNormal
+	const bool mirrored = transform.SwapsHandedness();
+	const int corners[3] = { 0, mirrored ? 2 : 1, mirrored ? 1 : 2 };
+
 	// loop over shapes
 	for (size_t s = 0; s < shapes.size(); ++s) {
 		size_t index_offset = 0;
@@ -50,7 +112,7 @@ TriangleMesh::TriangleMesh(std::shared_ptr<Material> m, const std::string& file,
 					const tinyobj::real_t nz =
 						attrib.normals[3 * static_cast<size_t>(idx.normal_index) + 2];
 
-					Vector3f n_world = transform.TransformVector(Vector3f(nx, ny, nz));
+					Vector3f n_world = transform.TransformNormal(Vector3f(nx, ny, nz));
 					normals.push_back(glm::normalize(Vector3f(n_world.x, n_world.y, n_world.z)));
 				}
 
@@ -69,7 +131,7 @@ TriangleMesh::TriangleMesh(std::shared_ptr<Material> m, const std::string& file,
 			if (normals.size() == 0) {
 				const Point3f v1 = glm::normalize(vertices[1] - vertices[0]);
 				const Point3f v2 = glm::normalize(vertices[2] - vertices[0]);
-				const Vector3f n = glm::normalize(glm::cross(v1, v2));
+				const Vector3f n = glm::normalize(mirrored ? glm::cross(v2, v1) : glm::cross(v1, v2));
 				normals.push_back(n);
 				normals.push_back(n);
 				normals.push_back(n);
@@ -82,7 +144,22 @@ TriangleMesh::TriangleMesh(std::shared_ptr<Material> m, const std::string& file,
 				texcoords.push_back(Point2f(0.0f, 1.0f));
 			}
 
-			for (int i = 0; i < 3; ++i) {
+			for (int c = 0; c < 3; ++c) {
+				// generated normals belong to this face only, generated texcoords to this corner only
+				const int i = corners[c];
+				const tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + i];
+				VertexKey key{ idx.vertex_index, idx.normal_index >= 0 ? idx.normal_index : -1 - face, idx.texcoord_index >= 0 ? idx.texcoord_index : -1 - i };
+
+				auto found = welded.find(key);
+				if (found != welded.end()) {
+					this->indices.push_back(found->second);
+
+					continue;
+				}
+
+				uint32_t index = this->vertices.size() / 3;
+				welded.emplace(key, index);
+
 				this->vertices.push_back(vertices[i][0]);
 				this->vertices.push_back(vertices[i][1]);
 				this->vertices.push_back(vertices[i][2]);
@@ -94,47 +171,148 @@ TriangleMesh::TriangleMesh(std::shared_ptr<Material> m, const std::string& file,
 				this->texcoords.push_back(texcoords[i][0]);
 				this->texcoords.push_back(texcoords[i][1]);
 
-				this->indices.push_back(this->indices.size());
+				this->indices.push_back(index);
 			}
 
 			index_offset += fv;
+			face++;
 		}
 	}
-}
 
-int TriangleMesh::ConstructEmbreeObject(RTCDevice& rtc_device, RTCScene& rtc_scene) {
-	RTCGeometry geom = rtcNewGeometry(rtc_device, RTC_GEOMETRY_TYPE_TRIANGLE);
+	size_t unweldedBytes = 3 * faces * (8 * sizeof(float) + sizeof(uint32_t));
+	size_t weldedBytes = (this->vertices.size() + this->normals.size() + this->texcoords.size()) * sizeof(float) + this->indices.size() * sizeof(uint32_t);
+	// one write per line, meshes may be loaded on several threads
+	std::ostringstream log;
+	log << "Load " << file << ": " << faces << " faces, vertices " << 3 * faces << " -> " << this->vertices.size() / 3
+		<< ", " << unweldedBytes / 1024 << " KB -> " << weldedBytes / 1024 << " KB\n";
+	std::cout << log.str();
+
+	// Embree reads vertices with 16 byte loads, the shared vertex buffer needs one float of padding
+	this->vertices.push_back(0.0f);
+	UseOwnedArrays();
+}
 
-	// set vertices
-	float* vb = (float*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0,
-		RTC_FORMAT_FLOAT3,
-		3 * sizeof(float),
-		Vertices());
-	for (int i = 0; i < vertices.size(); ++i) {
-		vb[i] = vertices[i];
+bool TriangleMesh::LoadBinary(const std::string& file) {
+	auto t1 = std::chrono::steady_clock::now();
+	auto mapped = std::make_shared<MappedFile>(file);
+	const MeshFileHeader* header = GetMeshFileHeader(*mapped);
+	if (header == NULL) {
+		return false;
 	}
 
-	// set indices
-	unsigned* ib = (unsigned*)rtcSetNewGeometryBuffer(
-		geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, 3 * sizeof(unsigned),
-		Faces());
-	for (int i = 0; i < indices.size(); ++i) {
-		ib[i] = indices[i];
+	const char* data = mapped->GetData();
+	numVertices = header->vertices;
+	numFaces = header->faces;
+	vertexData = reinterpret_cast<const float*>(data + header->positionOffset);
+	indexData = reinterpret_cast<const uint32_t*>(data + header->indexOffset);
+	normalData = reinterpret_cast<const float*>(data + header->normalOffset);
+	texcoordData = reinterpret_cast<const float*>(data + header->texcoordOffset);
+
+	// positions and normals of a placed mesh are copied out, indices and texcoords stay mapped.
+	// A mirroring transform also copies out the indices with the winding swapped, the same as LoadObj does
+	if (transform.SwapsHandedness()) {
+		indices.resize(3 * static_cast<size_t>(numFaces));
+		for (uint32_t f = 0; f < numFaces; f++) {
+			indices[3 * f + 0] = indexData[3 * f + 0];
+			indices[3 * f + 1] = indexData[3 * f + 2];
+			indices[3 * f + 2] = indexData[3 * f + 1];
+		}
+		indexData = indices.data();
+	}
+	if (!transform.IsIdentity()) {
+		vertices.resize(3 * static_cast<size_t>(numVertices) + 1);
+		normals.resize(3 * static_cast<size_t>(numVertices));
+		Matrix3f normalMatrix = transform.NormalMatrix();
+		for (uint32_t i = 0; i < numVertices; i++) {
+			Point3f v = transform.TransformPoint(GetVertex(i));
+			Vector3f n = glm::normalize(normalMatrix * GetVertexNormal(i));
+			for (int k = 0; k < 3; k++) {
+				vertices[3 * i + k] = v[k];
+				normals[3 * i + k] = n[k];
+			}
+		}
+		vertices.back() = 0.0f;
+		vertexData = vertices.data();
+		normalData = normals.data();
 	}
+	mapping = mapped;
+
+	std::ostringstream log;
+	log << "Map " << file << ": " << numFaces << " faces, " << numVertices << " vertices, "
+		<< mapped->GetSize() / 1024 << " KB in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count() << " ms\n";
+	std::cout << log.str();
+
+	return true;
+}
+
+void TriangleMesh::UseOwnedArrays() {
+	numVertices = static_cast<uint32_t>(vertices.size() / 3);
+	numFaces = static_cast<uint32_t>(indices.size() / 3);
+	vertexData = vertices.data();
+	indexData = indices.data();
+	normalData = normals.data();
+	texcoordData = texcoords.data();
+}
+
+bool TriangleMesh::SaveBinary(const std::string& file) const {
+	return WriteMeshFile(file, numVertices, numFaces, vertexData, indexData, normalData, texcoordData);
+}
+
+int TriangleMesh::ConstructEmbreeObject(RTCDevice& rtc_device, RTCScene& rtc_scene) {
+	RTCGeometry geom = rtcNewGeometry(rtc_device, RTC_GEOMETRY_TYPE_TRIANGLE);
+
+	// Embree reads the mesh arrays or the mapped file in place, they must outlive the scene
+	rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, vertexData, 0, 3 * sizeof(float), Vertices());
+	rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, indexData, 0, 3 * sizeof(uint32_t), Faces());
+	SetGeometryVisibility(rtc_device, geom);
 
 	rtcCommitGeometry(geom);
-	this->geometry_id = rtcAttachGeometry(rtc_scene, geom);
+	AttachGeometry(rtc_scene, geom);
 	rtcReleaseGeometry(geom);
-	rtcCommitScene(rtc_scene);
 
 	return 0;
 }
 
+RTCScene TriangleMesh::GetPrototypeScene(RTCDevice& rtc_device, RTCSceneFlags flags) {
+	if (prototypeScene == NULL) {
+		prototypeScene = rtcNewScene(rtc_device);
+		rtcSetSceneFlags(prototypeScene, flags);
+		ConstructEmbreeObject(rtc_device, prototypeScene);
+		rtcCommitScene(prototypeScene);
+	}
+
+	return prototypeScene;
+}
+
+TriangleMesh::~TriangleMesh() {
+	if (prototypeScene != NULL) {
+		rtcReleaseScene(prototypeScene);
+		prototypeScene = NULL;
+	}
+}
+
+// Hit record of a sphere at distance t along the ray, the UV is left to the closest hit
+static RTCHit MakeSphereHit(const Point3f& org, const Vector3f& dir, float t, const SpherePrimitive& sphere, unsigned int primID, unsigned int instID) {
+	Vector3f ng = glm::normalize(org + dir * t - sphere.center);
+
+	RTCHit hit;
+	hit.u = 0.0f;
+	hit.v = 0.0f;
+	hit.geomID = sphere.geomID;
+	hit.primID = primID;
+	hit.instID[0] = instID;
+	hit.Ng_x = ng.x;
+	hit.Ng_y = ng.y;
+	hit.Ng_z = ng.z;
+
+	return hit;
+}
+
 // Bounding box construction routine
 void Sphere::SphereBoundsFunc(const struct RTCBoundsFunctionArguments* args) {
-	const Sphere* spheres = (const Sphere*)args->geometryUserPtr;
+	const SpherePrimitive* spheres = (const SpherePrimitive*)args->geometryUserPtr;
 	RTCBounds* bounds_o = args->bounds_o;
-	const Sphere& sphere = spheres[args->primID];
+	const SpherePrimitive& sphere = spheres[args->primID];
 
 	bounds_o->lower_x = sphere.center.x - sphere.radius;
 	bounds_o->lower_y = sphere.center.y - sphere.radius;
@@ -144,135 +322,191 @@ void Sphere::SphereBoundsFunc(const struct RTCBoundsFunctionArguments* args) {
 	bounds_o->upper_z = sphere.center.z + sphere.radius;
 }
 
-// Intersection routine
+// Intersection routine, streams and packets hand over N rays at once
 void Sphere::SphereIntersectFunc(const RTCIntersectFunctionNArguments* args) {
 	int* valid = args->valid;
 	void* ptr = args->geometryUserPtr;
-	RTCRayHit* rayhit = (RTCRayHit*)args->rayhit;
+	unsigned int N = args->N;
+	RTCRayN* rays = RTCRayHitN_RayN(args->rayhit, N);
+	RTCHitN* hits = RTCRayHitN_HitN(args->rayhit, N);
 	unsigned int primID = args->primID;
 
-	Point3f org(rayhit->ray.org_x, rayhit->ray.org_y, rayhit->ray.org_z);
-	Vector3f dir(rayhit->ray.dir_x, rayhit->ray.dir_y, rayhit->ray.dir_z);
+	const SpherePrimitive* spheres = (const SpherePrimitive*)ptr;
+	const SpherePrimitive& sphere = spheres[primID];
+	Point3f center = sphere.center;
 
-	assert(args->N == 1);
+	for (unsigned int i = 0; i < N; i++) {
+		if (!valid[i]) {
+			continue;
+		}
 
-	const Sphere* spheres = (const Sphere*)ptr;
-	const Sphere& sphere = spheres[primID];
+		// The geometry mask of a batch is the union of its spheres
+		if ((RTCRayN_mask(rays, N, i) & sphere.visibility) == 0) {
+			continue;
+		}
 
-	if (!valid[0]) {
-		return;
-	}
+		Point3f org(RTCRayN_org_x(rays, N, i), RTCRayN_org_y(rays, N, i), RTCRayN_org_z(rays, N, i));
+		Vector3f dir(RTCRayN_dir_x(rays, N, i), RTCRayN_dir_y(rays, N, i), RTCRayN_dir_z(rays, N, i));
 
-	Point3f center = sphere.center;
+		const Vector3f op = center - org;
+		const float dop = glm::dot(dir, op);
+		const float D = dop * dop - glm::dot(op, op) + sphere.radius * sphere.radius;
 
-	const Vector3f op = center - org;
-	const float dop = glm::dot(dir, op);
-	const float D = dop * dop - glm::dot(op, op) + sphere.radius * sphere.radius;
+		if (D < 0.0f) {
+			continue;
+		}
 
-	if (D < 0.0f) {
-		return;
-	}
+		const float sqrtD = sqrt(D);
+
+		// Filter functions see the candidate as a single ray ending at it, the instance also clears the one of an earlier, farther hit
+		auto ReportHit = [&](float t) {
+			RTCHit hit = MakeSphereHit(org, dir, t, sphere, primID, args->context->instID[0]);
+			RTCRay ray = rtcGetRayFromRayN(rays, N, i);
+			ray.tfar = t;
+
+			int accept = -1;
+			RTCFilterFunctionNArguments filterArgs;
+			filterArgs.valid = &accept;
+			filterArgs.geometryUserPtr = ptr;
+			filterArgs.context = args->context;
+			filterArgs.ray = (RTCRayN*)&ray;
+			filterArgs.hit = (RTCHitN*)&hit;
+			filterArgs.N = 1;
+			rtcFilterIntersection(args, &filterArgs);
+
+			if (accept == -1) {
+				RTCRayN_tfar(rays, N, i) = t;
+				rtcCopyHitToHitN(hits, &hit, N, i);
+			}
+		};
 
-	const float sqrtD = sqrt(D);
-
-	const float tmin = dop - sqrtD;
-	if (rayhit->ray.tnear < tmin && tmin < rayhit->ray.tfar) {
-		rayhit->ray.tfar = tmin;
-		Point3f p = GetHitPos(*rayhit);
-		Point2f uv = GetSphereUV(p, center);
-
-		rayhit->hit.u = uv.x;
-		rayhit->hit.v = uv.y;
-		rayhit->hit.geomID = sphere.geometry_id;
-		rayhit->hit.primID = primID;
-		Vector3f ng = glm::normalize(org + dir * tmin - center);
-		rayhit->hit.Ng_x = ng.x;
-		rayhit->hit.Ng_y = ng.y;
-		rayhit->hit.Ng_z = ng.z;
-	}
+		const float tmin = dop - sqrtD;
+		if (RTCRayN_tnear(rays, N, i) < tmin && tmin < RTCRayN_tfar(rays, N, i)) {
+			ReportHit(tmin);
+		}
 
-	const float tmax = dop + sqrtD;
-	if (rayhit->ray.tnear < tmax && tmax < rayhit->ray.tfar) {
-		rayhit->ray.tfar = tmax;
-		Point3f p = GetHitPos(*rayhit);
-		Point2f uv = GetSphereUV(p, center);
-
-		rayhit->hit.u = uv.x;
-		rayhit->hit.v = uv.y;
-		rayhit->hit.geomID = sphere.geometry_id;
-		rayhit->hit.primID = primID;
-		Vector3f ng = glm::normalize(org + dir * tmax - center);
-		rayhit->hit.Ng_x = ng.x;
-		rayhit->hit.Ng_y = ng.y;
-		rayhit->hit.Ng_z = ng.z;
+		const float tmax = dop + sqrtD;
+		if (RTCRayN_tnear(rays, N, i) < tmax && tmax < RTCRayN_tfar(rays, N, i)) {
+			ReportHit(tmax);
+		}
 	}
-
-	return;
 }
 
-// Occlusion routine
+// Occlusion routine, an occluded ray is marked with tfar = -inf
 void Sphere::SphereOccludedFunc(const RTCOccludedFunctionNArguments* args) {
-	// TODO: Implement the occlusion routine and make sure to use it for shadow rays or something similar
-	// Hint: It's almost the same as sphereIntersectFunc
 	int* valid = args->valid;
 	void* ptr = args->geometryUserPtr;
-	RTCRay* ray = (RTCRay*)args->ray;
+	unsigned int N = args->N;
+	RTCRayN* rays = args->ray;
 	unsigned int primID = args->primID;
 
-	Point3f org(ray->org_x, ray->org_y, ray->org_z);
-	Vector3f dir(ray->dir_x, ray->dir_y, ray->dir_z);
-
-	assert(args->N == 1);
+	const SpherePrimitive* spheres = (const SpherePrimitive*)ptr;
+	const SpherePrimitive& sphere = spheres[primID];
+	Point3f center = sphere.center;
 
-	const Sphere* spheres = (const Sphere*)ptr;
-	const Sphere& sphere = spheres[primID];
+	for (unsigned int i = 0; i < N; i++) {
+		if (!valid[i]) {
+			continue;
+		}
 
-	if (!valid[0]) {
-		return;
-	}
+		// The geometry mask of a batch is the union of its spheres
+		if ((RTCRayN_mask(rays, N, i) & sphere.visibility) == 0) {
+			continue;
+		}
 
-	Point3f center = sphere.center;
+		Point3f org(RTCRayN_org_x(rays, N, i), RTCRayN_org_y(rays, N, i), RTCRayN_org_z(rays, N, i));
+		Vector3f dir(RTCRayN_dir_x(rays, N, i), RTCRayN_dir_y(rays, N, i), RTCRayN_dir_z(rays, N, i));
 
-	const Vector3f op = center - org;
-	const float dop = glm::dot(dir, op);
-	const float D = dop * dop - glm::dot(op, op) + sphere.radius * sphere.radius;
+		const Vector3f op = center - org;
+		const float dop = glm::dot(dir, op);
+		const float D = dop * dop - glm::dot(op, op) + sphere.radius * sphere.radius;
 
-	if (D < 0.0f) {
-		return;
-	}
+		if (D < 0.0f) {
+			continue;
+		}
 
-	const float sqrtD = sqrt(D);
+		const float sqrtD = sqrt(D);
+		const float tnear = RTCRayN_tnear(rays, N, i);
+		const float tfar = RTCRayN_tfar(rays, N, i);
+
+		auto ReportOcclusion = [&](float t) {
+			RTCHit hit = MakeSphereHit(org, dir, t, sphere, primID, args->context->instID[0]);
+			RTCRay ray = rtcGetRayFromRayN(rays, N, i);
+			ray.tfar = t;
+
+			int accept = -1;
+			RTCFilterFunctionNArguments filterArgs;
+			filterArgs.valid = &accept;
+			filterArgs.geometryUserPtr = ptr;
+			filterArgs.context = args->context;
+			filterArgs.ray = (RTCRayN*)&ray;
+			filterArgs.hit = (RTCHitN*)&hit;
+			filterArgs.N = 1;
+			rtcFilterOcclusion(args, &filterArgs);
+
+			if (accept == -1) {
+				RTCRayN_tfar(rays, N, i) = -Infinity;
+			}
 
-	const float tmin = dop - sqrtD;
-	if (ray->tnear < tmin && tmin < ray->tfar) {
-		ray->tfar = tmin;
-	}
+			return accept == -1;
+		};
 
-	const float tmax = dop + sqrtD;
-	if (ray->tnear < tmax && tmax < ray->tfar) {
-		ray->tfar = tmax;
+		const float tmin = dop - sqrtD;
+		const float tmax = dop + sqrtD;
+		if (tnear < tmin && tmin < tfar && ReportOcclusion(tmin)) {
+			continue;
+		}
+		if (tnear < tmax && tmax < tfar) {
+			ReportOcclusion(tmax);
+		}
 	}
-
-	return;
 }
 
-// Construction of Embree object from the analytically given sphere
+// Construction of Embree object from the analytically given sphere, scenes merge their spheres with ConstructEmbreeBatch instead
 int Sphere::ConstructEmbreeObject(RTCDevice& rtc_device, RTCScene& rtc_scene) {
 	RTCGeometry geom = rtcNewGeometry(rtc_device, RTC_GEOMETRY_TYPE_USER);
-	this->geometry_id = rtcAttachGeometry(rtc_scene, geom);
+	AttachGeometry(rtc_scene, geom);
+	primitive = GetPrimitive();
 
 	rtcSetGeometryUserPrimitiveCount(geom, 1);
-	rtcSetGeometryUserData(geom, this);
+	rtcSetGeometryUserData(geom, &primitive);
 
 	rtcSetGeometryBoundsFunction(geom, SphereBoundsFunc, nullptr);
 	rtcSetGeometryIntersectFunction(geom, SphereIntersectFunc);
 	rtcSetGeometryOccludedFunction(geom, SphereOccludedFunc);
+	SetGeometryVisibility(rtc_device, geom);
 	rtcCommitGeometry(geom);
 	rtcReleaseGeometry(geom);
 
 	return 0;
 }
 
+void Sphere::ConstructEmbreeBatch(RTCDevice& rtc_device, RTCScene& rtc_scene, const std::vector<SpherePrimitive>& spheres, unsigned int geomID) {
+	RTCGeometry geom = rtcNewGeometry(rtc_device, RTC_GEOMETRY_TYPE_USER);
+	rtcSetGeometryUserPrimitiveCount(geom, spheres.size());
+	rtcSetGeometryUserData(geom, (void*)spheres.data());
+
+	rtcSetGeometryBoundsFunction(geom, SphereBoundsFunc, nullptr);
+	rtcSetGeometryIntersectFunction(geom, SphereIntersectFunc);
+	rtcSetGeometryOccludedFunction(geom, SphereOccludedFunc);
+
+	// The callbacks test the visibility of every sphere
+	uint32_t mask = 0;
+	for (const auto& sphere : spheres) {
+		mask |= sphere.visibility;
+	}
+	rtcSetGeometryMask(geom, mask);
+
+	rtcCommitGeometry(geom);
+	rtcAttachGeometryByID(rtc_scene, geom, geomID);
+	rtcReleaseGeometry(geom);
+}
+
+
+SpherePrimitive Sphere::GetPrimitive() const {
+	return SpherePrimitive{ center, radius, static_cast<unsigned int>(geometry_id), visibility };
+}
+
 Point2f Sphere::GetSphereUV(const Point3f& surface_pos, const Point3f& center) {
 	Vector3f dir = glm::normalize(surface_pos - center);
 
@@ -307,12 +541,13 @@ int Quad::ConstructEmbreeObject(RTCDevice& rtc_device, RTCScene& rtc_scene) {
 	quads[0].y = 1;
 	quads[0].z = 2;
 	quads[0].w = 3;
+	SetGeometryVisibility(rtc_device, mesh);
 
 	// Commiting the geometry
 	rtcCommitGeometry(mesh);
 
 	// Attaching it to the scene and getting the primitive's Id
-	this->geometry_id = rtcAttachGeometry(rtc_scene, mesh);
+	AttachGeometry(rtc_scene, mesh);
 
 	rtcReleaseGeometry(mesh);
 
@@ -330,16 +565,84 @@ Point2f Quad::GetQuadUV(const Point3f& p, const Point3f& position, const Vector3
 	return uv;
 }
 
+Instance::Instance(std::shared_ptr<Material> m, TriangleMesh* proto, const Transform& trans, std::shared_ptr<Medium> out, std::shared_ptr<Medium> in) :
+	Shape(ShapeType::InstanceShape, m, trans, out, in), prototype(proto) {
+	normalMatrix = trans.NormalMatrix();
+}
+
+int Instance::ConstructEmbreeObject(RTCDevice& rtc_device, RTCScene& rtc_scene) {
+	RTCGeometry geom = rtcNewGeometry(rtc_device, RTC_GEOMETRY_TYPE_INSTANCE);
+	rtcSetGeometryInstancedScene(geom, prototype->GetPrototypeScene(rtc_device, rtcGetSceneFlags(rtc_scene)));
+
+	Matrix4f mat = transform.Mat();
+	rtcSetGeometryTransform(geom, 0, RTC_FORMAT_FLOAT4X4_COLUMN_MAJOR, glm::value_ptr(mat));
+	SetGeometryVisibility(rtc_device, geom);
+
+	rtcCommitGeometry(geom);
+	AttachGeometry(rtc_scene, geom);
+	rtcReleaseGeometry(geom);
+
+	return 0;
+}
+
+void Shape::AttachGeometry(RTCScene& rtc_scene, RTCGeometry geom) {
+	if (geometry_id >= 0) {
+		rtcAttachGeometryByID(rtc_scene, geom, geometry_id);
+	}
+	else {
+		geometry_id = rtcAttachGeometry(rtc_scene, geom);
+	}
+}
+
+void Shape::SetGeometryVisibility(RTCDevice& rtc_device, RTCGeometry geom) {
+	rtcSetGeometryMask(geom, visibility);
+	if (visibility == RayVisibility::AllVisibility || rtcGetDeviceProperty(rtc_device, RTC_DEVICE_PROPERTY_RAY_MASK_SUPPORTED)) {
+		return;
+	}
+
+	// Spheres test the mask in their own callbacks, filter functions are not called for instances
+	if (m_type == ShapeType::InstanceShape) {
+		printf("Embree is built without ray masks, visibility of instance %d is ignored\n", geometry_id);
+	}
+	else if (m_type != ShapeType::SphereShape) {
+		rtcSetGeometryUserData(geom, this);
+		rtcSetGeometryIntersectFilterFunction(geom, VisibilityFilterFunc);
+		rtcSetGeometryOccludedFilterFunction(geom, VisibilityFilterFunc);
+	}
+}
+
+// Rejects the hits of ray types the shape is hidden from
+void Shape::VisibilityFilterFunc(const RTCFilterFunctionNArguments* args) {
+	const Shape* shape = (const Shape*)args->geometryUserPtr;
+	for (unsigned int i = 0; i < args->N; i++) {
+		if (args->valid[i] != -1) {
+			continue;
+		}
+
+		if ((RTCRayN_mask(args->ray, args->N, i) & shape->visibility) == 0) {
+			args->valid[i] = 0;
+		}
+	}
+}
+
 Shape* Shape::Create(const ShapeParams& params) {
+	Shape* shape = NULL;
 	if (params.type == ShapeType::TriangleMeshShape) {
-		return new TriangleMesh(params.material, params.file, params.transform, params.out_medium, params.in_medium);
+		shape = new TriangleMesh(params.material, params.file, params.transform, params.out_medium, params.in_medium);
 	}
 	else if (params.type == ShapeType::SphereShape) {
-		return new Sphere(params.material, params.center, params.radius, params.out_medium, params.in_medium);
+		shape = new Sphere(params.material, params.center, params.radius, params.out_medium, params.in_medium);
 	}
 	else if (params.type == ShapeType::QuadShape) {
-		return new Quad(params.material, params.position, params.u, params.v, params.out_medium, params.in_medium);
+		shape = new Quad(params.material, params.position, params.u, params.v, params.out_medium, params.in_medium);
+	}
+	else if (params.type == ShapeType::InstanceShape) {
+		shape = new Instance(params.material, params.prototype, params.transform, params.out_medium, params.in_medium);
+	}
+
+	if (shape != NULL) {
+		shape->SetVisibility(params.visibility);
 	}
 
-	return NULL;
+	return shape;
 }
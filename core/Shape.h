@@ -3,11 +3,13 @@
 #include "Utils.h"
 #include "Transform.h"
 #include "Material.h"
+#include "MeshFile.h"
 
 enum ShapeType {
 	TriangleMeshShape,
 	SphereShape,
 	QuadShape,
+	InstanceShape,
 };
 
 struct ShapeParams {
@@ -22,15 +24,19 @@ struct ShapeParams {
 	Point3f position;
 	Vector3f u;
 	Vector3f v;
+	TriangleMesh* prototype = NULL;
+	uint32_t visibility = RayVisibility::AllVisibility;
 };
 
 class Shape {
 	friend Light;
 
 public:
-	Shape(ShapeType type, std::shared_ptr<Material> m, const Transform& trans, std::shared_ptr<Medium> out = NULL , std::shared_ptr<Medium> in = NULL, int geom_id = 0) :
+	Shape(ShapeType type, std::shared_ptr<Material> m, const Transform& trans, std::shared_ptr<Medium> out = NULL , std::shared_ptr<Medium> in = NULL, int geom_id = -1) :
 	    m_type(type), material(m), transform(trans), out_medium(out), in_medium(in), geometry_id(geom_id) {}
 
+	virtual ~Shape() = default;
+
 	inline ShapeType GetType() const {
 		return m_type;
 	}
@@ -39,6 +45,11 @@ public:
 		return geometry_id;
 	}
 
+	// Scenes hand out the shape index as geometry ID before construction, -1 takes the next free ID on attach
+	inline void SetGeometryID(int id) {
+		geometry_id = id;
+	}
+
 	inline std::shared_ptr<Material> GetMaterial() const {
 		return material;
 	}
@@ -51,6 +62,15 @@ public:
 		return in_medium;
 	}
 
+	inline uint32_t GetVisibility() const {
+		return visibility;
+	}
+
+	// RayVisibility bits of the ray types that can hit the shape, set before Scene::Commit
+	inline void SetVisibility(uint32_t v) {
+		visibility = v;
+	}
+
 	inline virtual Vector3f GetGeometryNormal(uint32_t faceID) const {
 		return Point3f(0.0f);
 	}
@@ -63,11 +83,19 @@ public:
 		return Point2f(0.0f); 
 	}
 
-	// Creating and committing the current object to Embree scene
+	// Creating and attaching the current object to Embree scene, Scene::Commit commits the scene once
 	virtual int ConstructEmbreeObject(RTCDevice& rtc_device, RTCScene& rtc_scene) = 0;
 
 	static Shape* Create(const ShapeParams& params);
 
+protected:
+	void AttachGeometry(RTCScene& rtc_scene, RTCGeometry geom);
+
+	// Visibility becomes the Embree geometry mask, Embree builds without ray masks fall back to a filter function
+	void SetGeometryVisibility(RTCDevice& rtc_device, RTCGeometry geom);
+
+	static void VisibilityFilterFunc(const RTCFilterFunctionNArguments* args);
+
 protected:
 	ShapeType m_type;
 	Transform transform;
@@ -75,41 +103,45 @@ protected:
 	std::shared_ptr<Material> material;
 	std::shared_ptr<Medium> out_medium;
 	std::shared_ptr<Medium> in_medium;
+	uint32_t visibility = RayVisibility::AllVisibility;
 };
 
 class TriangleMesh : public Shape {
 	friend TriangleMeshArea;
 
 public:
-	TriangleMesh(std::shared_ptr<Material> m, const std::string& file, const Transform& trans, std::shared_ptr<Medium> out = NULL, std::shared_ptr<Medium> in = NULL);
+	// useBinary = false always parses an OBJ, even if an up-to-date binary file lies next to it
+	TriangleMesh(std::shared_ptr<Material> m, const std::string& file, const Transform& trans, std::shared_ptr<Medium> out = NULL, std::shared_ptr<Medium> in = NULL,
+		bool useBinary = true);
 
+	// vertex data ends with one float of padding for Embree
 	inline uint32_t Vertices() const { 
-		return vertices.size() / 3; 
+		return numVertices; 
 	}
 
 	inline uint32_t Faces() const { 
-		return indices.size() / 3; 
+		return numFaces; 
 	}
 
 	inline Point3u GetIndices(uint32_t faceID) const {
-		return Point3u(indices[3 * faceID + 0], indices[3 * faceID + 1], indices[3 * faceID + 2]);
+		return Point3u(indexData[3 * faceID + 0], indexData[3 * faceID + 1], indexData[3 * faceID + 2]);
 	}
 
 	// return vertex
 	inline Vector3f GetVertex(uint32_t vertexID) const {
-		return Vector3f(vertices[3 * vertexID + 0], vertices[3 * vertexID + 1],
-			vertices[3 * vertexID + 2]);
+		return Vector3f(vertexData[3 * vertexID + 0], vertexData[3 * vertexID + 1],
+			vertexData[3 * vertexID + 2]);
 	}
 
 	// return vertex normal
 	inline Vector3f GetVertexNormal(uint32_t vertexID) const {
-		return Vector3f(normals[3 * vertexID + 0], normals[3 * vertexID + 1],
-			normals[3 * vertexID + 2]);
+		return Vector3f(normalData[3 * vertexID + 0], normalData[3 * vertexID + 1],
+			normalData[3 * vertexID + 2]);
 	}
 
 	// return vertex texcoords of specified face
 	inline Point2f GetVertexTexcoords(uint32_t vertexID) const {
-		return Point2f(texcoords[2 * vertexID + 0], texcoords[2 * vertexID + 1]);
+		return Point2f(texcoordData[2 * vertexID + 0], texcoordData[2 * vertexID + 1]);
 	}
 
 	// compute geometry normal
@@ -147,11 +179,45 @@ public:
 	// Creating and commiting the current object to Embree scene
 	virtual int ConstructEmbreeObject(RTCDevice& rtc_device, RTCScene& rtc_scene) override;
 
+	// Scene holding only this mesh, built on first use with the flags of the first scene instancing it and shared by every instance of it
+	RTCScene GetPrototypeScene(RTCDevice& rtc_device, RTCSceneFlags flags);
+
+	// Write the mesh in the binary format, transformed as loaded
+	bool SaveBinary(const std::string& file) const;
+
+	~TriangleMesh();
+
+private:
+	void LoadObj(const std::string& file);
+
+	// Map a binary mesh file, its blocks are used in place unless the transform has to be applied
+	bool LoadBinary(const std::string& file);
+
+	// Point the data views at the owned arrays
+	void UseOwnedArrays();
+
 private:
 	std::vector<float> vertices;
 	std::vector<uint32_t> indices;
 	std::vector<float> normals;
 	std::vector<float> texcoords;
+	// Views of the mesh data, pointing into the arrays above or into the mapped file
+	const float* vertexData = NULL;
+	const uint32_t* indexData = NULL;
+	const float* normalData = NULL;
+	const float* texcoordData = NULL;
+	uint32_t numVertices = 0;
+	uint32_t numFaces = 0;
+	std::shared_ptr<MappedFile> mapping;
+	RTCScene prototypeScene = NULL;
+};
+
+// Packed sphere the Embree callbacks read, hits report geomID, the geometry ID of the Sphere shape
+struct SpherePrimitive {
+	Point3f center;
+	float radius;
+	unsigned int geomID;
+	uint32_t visibility;
 };
 
 class Sphere : public Shape {
@@ -171,11 +237,22 @@ public:
 	// Creating and commiting the current object to Embree scene
 	virtual int ConstructEmbreeObject(RTCDevice& rtc_device, RTCScene& rtc_scene) override;
 
+	// One user geometry with a primitive per sphere attached under geomID, spheres must outlive the scene
+	static void ConstructEmbreeBatch(RTCDevice& rtc_device, RTCScene& rtc_scene, const std::vector<SpherePrimitive>& spheres, unsigned int geomID);
+
+	SpherePrimitive GetPrimitive() const;
+
+	// Only computed for the closest hit
+	inline Point2f GetUV(const Point3f& p) const {
+		return GetSphereUV(p, center);
+	}
+
 	static Point2f GetSphereUV(const Point3f& surface_pos, const Point3f& center);
 
 private:
 	Point3f center;
 	float radius;
+	SpherePrimitive primitive;// callback data of a sphere built as its own geometry
 };
 
 class Quad : public Shape {
@@ -194,4 +271,35 @@ private:
 	Point3f position;
 	Vector3f u;
 	Vector3f v;
-};
\ No newline at end of file
+};
+
+// Places a shared prototype mesh with its own transform, the triangles are stored once for every instance
+class Instance : public Shape {
+public:
+	// The prototype is not owned, it stays with whoever loaded it and must outlive the instance
+	Instance(std::shared_ptr<Material> m, TriangleMesh* proto, const Transform& trans, std::shared_ptr<Medium> out = NULL, std::shared_ptr<Medium> in = NULL);
+
+	inline TriangleMesh* GetPrototype() const {
+		return prototype;
+	}
+
+	// Both normals go through Transform::TransformNormal, the same as a mesh baked with the transform,
+	// whose winding is swapped under a mirroring transform so its geometric normal agrees with that
+	inline virtual Vector3f GetGeometryNormal(uint32_t faceID) const override {
+		return glm::normalize(normalMatrix * prototype->GetGeometryNormal(faceID));
+	}
+
+	inline virtual Vector3f GetShadeNormal(uint32_t faceID, const Point2f& barycentric) const override {
+		return glm::normalize(normalMatrix * prototype->GetShadeNormal(faceID, barycentric));
+	}
+
+	inline virtual Point2f GetTexcoords(uint32_t faceID, const Point2f& barycentric) const override {
+		return prototype->GetTexcoords(faceID, barycentric);
+	}
+
+	virtual int ConstructEmbreeObject(RTCDevice& rtc_device, RTCScene& rtc_scene) override;
+
+private:
+	TriangleMesh* prototype;
+	Matrix3f normalMatrix;
+};
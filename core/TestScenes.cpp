@@ -1,11 +1,15 @@
 #include "TestScenes.h"
+#include "AssetLoader.h"
 
-RTCDevice rtc_device = rtcNewDevice(NULL);
-
-std::shared_ptr<Renderer> TestScenes::Diningroom_MeshLight() {
+RendererParams TestScenes::Diningroom_MeshLight(IntegratorType type, const EmbreeParams& embree) {
 	int Width = 1200;
 	int Height = 1000;
 
+	// Asset
+	AssetLoader loader;
+	auto tiles_texture = loader.LoadTexture<Image>("scenes/diningroom/textures/Tiles.jpg");
+	auto picture_texture = loader.LoadTexture<Image>("scenes/diningroom/textures/picture.jpg");
+
 	// Material
 	float yellow[3] = { 0.75f, 0.8f, 0.7f };
 	float radiance[3] = { 17.0f, 12.0f, 8.0f };
@@ -17,10 +21,10 @@ std::shared_ptr<Renderer> TestScenes::Diningroom_MeshLight() {
 	float roughness[3] = { 0.1f };
 	float roughness2[3] = { 0.3f };
 	auto light_material = std::make_shared<DiffuseLight>(Spectrum::FromRGB(radiance));
-	auto floor_material = std::make_shared<Diffuse>(std::make_shared<Image>("scenes/diningroom/textures/Tiles.jpg"), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
+	auto floor_material = std::make_shared<Diffuse>(tiles_texture.get(), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
 	auto wall_material = std::make_shared<Diffuse>(std::make_shared<Constant>(Spectrum::FromRGB(albedo)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
 	auto light2_window_material = std::make_shared<Diffuse>(std::make_shared<Constant>(Spectrum::FromRGB(albedo2)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
-	auto wall_picture_material = std::make_shared<Diffuse>(std::make_shared<Image>("scenes/diningroom/textures/picture.jpg"), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
+	auto wall_picture_material = std::make_shared<Diffuse>(picture_texture.get(), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
 	auto table1_chair_spoon_material = std::make_shared<Plastic>(std::make_shared<Constant>(Spectrum::FromRGB(diffuse)), std::make_shared<Constant>(Spectrum::FromRGB(specular)),
 		 		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.5f, 1.0f, true);
 	auto table2_material = std::make_shared<Plastic>(std::make_shared<Constant>(Spectrum::FromRGB(diffuse)), std::make_shared<Constant>(Spectrum::FromRGB(specular)),
@@ -35,24 +39,24 @@ std::shared_ptr<Renderer> TestScenes::Diningroom_MeshLight() {
 		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.45f, 1.0f, true);
 
 	// Light
-	auto light = std::make_shared<TriangleMeshArea>(new TriangleMesh(light_material, "scenes/diningroom/models/light.obj", Transform()));
+	auto light_mesh = loader.LoadMesh(light_material, "scenes/diningroom/models/light.obj", Transform());
 
 	// Shape
- 	auto floor = new TriangleMesh(floor_material, "scenes/diningroom/models/floor.obj", Transform());
- 	auto wall = new TriangleMesh(wall_material, "scenes/diningroom/models/wall.obj", Transform());
-	auto light2 = new TriangleMesh(light2_window_material, "scenes/diningroom/models/light2.obj", Transform());
-	auto window = new TriangleMesh(light2_window_material, "scenes/diningroom/models/window.obj", Transform());
-	auto wall_picture = new TriangleMesh(wall_picture_material, "scenes/diningroom/models/wall_picture.obj", Transform());
-	auto table1 = new TriangleMesh(table1_chair_spoon_material, "scenes/diningroom/models/table1.obj", Transform());
-	auto table2 = new TriangleMesh(table2_material, "scenes/diningroom/models/table2.obj", Transform());
-	auto chair1 = new TriangleMesh(table1_chair_spoon_material, "scenes/diningroom/models/chair1.obj", Transform());
-	auto chair2 = new TriangleMesh(chair2_material, "scenes/diningroom/models/chair2.obj", Transform());
-	auto chair3 = new TriangleMesh(chair3_material, "scenes/diningroom/models/chair3.obj", Transform());
-	auto cup = new TriangleMesh(cup_material, "scenes/diningroom/models/cup.obj", Transform());
-	auto plate = new TriangleMesh(plate_material, "scenes/diningroom/models/plate.obj", Transform());
-	auto spoon = new TriangleMesh(table1_chair_spoon_material, "scenes/diningroom/models/spoon.obj", Transform());
-	auto pot = new TriangleMesh(teapot_material, "scenes/diningroom/models/pot.obj", Transform());
-	auto teapot = new TriangleMesh(teapot_material, "scenes/diningroom/models/teapot.obj", Transform());
+ 	auto floor = loader.LoadMesh(floor_material, "scenes/diningroom/models/floor.obj", Transform());
+ 	auto wall = loader.LoadMesh(wall_material, "scenes/diningroom/models/wall.obj", Transform());
+	auto light2 = loader.LoadMesh(light2_window_material, "scenes/diningroom/models/light2.obj", Transform());
+	auto window = loader.LoadMesh(light2_window_material, "scenes/diningroom/models/window.obj", Transform());
+	auto wall_picture = loader.LoadMesh(wall_picture_material, "scenes/diningroom/models/wall_picture.obj", Transform());
+	auto table1 = loader.LoadMesh(table1_chair_spoon_material, "scenes/diningroom/models/table1.obj", Transform());
+	auto table2 = loader.LoadMesh(table2_material, "scenes/diningroom/models/table2.obj", Transform());
+	auto chair1 = loader.LoadMesh(table1_chair_spoon_material, "scenes/diningroom/models/chair1.obj", Transform());
+	auto chair2 = loader.LoadMesh(chair2_material, "scenes/diningroom/models/chair2.obj", Transform());
+	auto chair3 = loader.LoadMesh(chair3_material, "scenes/diningroom/models/chair3.obj", Transform());
+	auto cup = loader.LoadMesh(cup_material, "scenes/diningroom/models/cup.obj", Transform());
+	auto plate = loader.LoadMesh(plate_material, "scenes/diningroom/models/plate.obj", Transform());
+	auto spoon = loader.LoadMesh(table1_chair_spoon_material, "scenes/diningroom/models/spoon.obj", Transform());
+	auto pot = loader.LoadMesh(teapot_material, "scenes/diningroom/models/pot.obj", Transform());
+	auto teapot = loader.LoadMesh(teapot_material, "scenes/diningroom/models/teapot.obj", Transform());
 
 	// Camera
 	auto camera = std::make_shared<Pinhole>(Point3f(-3.5f, 3.0f, 6.0f), Point3f(-1.0f, 1.7f, 0.0f), Vector3f(0.0f, 1.0f, 0.0f), 1.0f, 60.0f, (float)Width / (float)Height);
@@ -64,28 +68,29 @@ std::shared_ptr<Renderer> TestScenes::Diningroom_MeshLight() {
 	auto sampler = std::make_shared<Independent>();
 
 	// Scene
-	auto scene = std::make_shared<Scene>(rtc_device);
-	scene->AddLight(light);
-	scene->AddShape(floor);
-	scene->AddShape(wall);
-	scene->AddShape(light2);
-	scene->AddShape(window);
-	scene->AddShape(wall_picture);
-	scene->AddShape(table1);
-	scene->AddShape(table2);
-	scene->AddShape(chair1);
-	scene->AddShape(chair2);
-	scene->AddShape(chair3);
-	scene->AddShape(cup);
-	scene->AddShape(plate);
-	scene->AddShape(spoon);
-	scene->AddShape(pot);
-	scene->AddShape(teapot);
+	auto scene = std::make_shared<Scene>(embree);
+	scene->AddLight(std::make_shared<TriangleMeshArea>(light_mesh.get()));
+	scene->AddShape(floor.get());
+	scene->AddShape(wall.get());
+	scene->AddShape(light2.get());
+	scene->AddShape(window.get());
+	scene->AddShape(wall_picture.get());
+	scene->AddShape(table1.get());
+	scene->AddShape(table2.get());
+	scene->AddShape(chair1.get());
+	scene->AddShape(chair2.get());
+	scene->AddShape(chair3.get());
+	scene->AddShape(cup.get());
+	scene->AddShape(plate.get());
+	scene->AddShape(spoon.get());
+	scene->AddShape(pot.get());
+	scene->AddShape(teapot.get());
 	scene->SetCamera(camera);
 	scene->Commit();
 
 	// Integrator
-	auto integrator = std::make_shared<VolumetricPathTracing>(scene, sampler, filter, Width, Height, 64);
+	IntegratorParams integratorParams{ type, scene, sampler, filter, Width, Height, 64 };
+	auto integrator = Integrator::Create(integratorParams);
 
 	// ToneMapper
 	auto tone = std::make_shared<ACES>();
@@ -94,15 +99,21 @@ std::shared_ptr<Renderer> TestScenes::Diningroom_MeshLight() {
 	auto post = std::make_shared<PostProcessing>(tone, 0.0f);
 
 	// Renderer
-	auto renderer = std::make_shared<Renderer>(integrator, post);
+	RendererParams rendererParams{ integrator, post };
 
-	return renderer;
+	return rendererParams;
 }
 
-std::shared_ptr<Renderer> TestScenes::Diningroom_EnvironmentLight() {
+RendererParams TestScenes::Diningroom_EnvironmentLight(IntegratorType type, const EmbreeParams& embree) {
 	int Width = 1200;
 	int Height = 1000;
 
+	// Asset
+	AssetLoader loader;
+	auto tiles_texture = loader.LoadTexture<Image>("scenes/diningroom/textures/Tiles.jpg");
+	auto teacup_texture = loader.LoadTexture<Image>("scenes/diningroom/textures/Teacup.png");
+	auto spaichingen_hill_4k_texture = loader.LoadTexture<Hdr>("scenes/diningroom/textures/spaichingen_hill_4k.hdr");
+
 	// Material
 	float radiance[3] = { 16.0f, 8.0f, 4.0f };
 	float red[3] = { 0.8f, 0.3f, 0.3f };
@@ -117,10 +128,10 @@ std::shared_ptr<Renderer> TestScenes::Diningroom_EnvironmentLight() {
 	auto quadlight_material = std::make_shared<DiffuseLight>(Spectrum::FromRGB(radiance));
 	auto light_material = std::make_shared<Plastic>(std::make_shared<Constant>(Spectrum::FromRGB(red)), std::make_shared<Constant>(Spectrum::FromRGB(specular)),
 		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.5f, 1.0f, true);
-	auto floor_material = std::make_shared<Diffuse>(std::make_shared<Image>("scenes/diningroom/textures/Tiles.jpg"), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
+	auto floor_material = std::make_shared<Diffuse>(tiles_texture.get(), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
 	auto wall_material = std::make_shared<Diffuse>(std::make_shared<Constant>(Spectrum::FromRGB(albedo)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
 	auto light2_window_material = std::make_shared<Diffuse>(std::make_shared<Constant>(Spectrum::FromRGB(albedo2)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
-	auto wall_picture_material = std::make_shared<Diffuse>(std::make_shared<Image>("scenes/diningroom/textures/Teacup.png"), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
+	auto wall_picture_material = std::make_shared<Diffuse>(teacup_texture.get(), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
 	auto table1_chair_spoon_material = std::make_shared<Plastic>(std::make_shared<Constant>(Spectrum::FromRGB(diffuse)), std::make_shared<Constant>(Spectrum::FromRGB(specular)),
 		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.5f, 1.0f, true);
 	auto table2_material = std::make_shared<Plastic>(std::make_shared<Constant>(Spectrum::FromRGB(diffuse)), std::make_shared<Constant>(Spectrum::FromRGB(specular)),
@@ -134,27 +145,27 @@ std::shared_ptr<Renderer> TestScenes::Diningroom_EnvironmentLight() {
 	auto teapot_material = std::make_shared<Plastic>(std::make_shared<Constant>(Spectrum::FromRGB(albedo)), std::make_shared<Constant>(Spectrum::FromRGB(specular)),
 		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.45f, 1.0f, true);
 
-	// Light
-	auto envlight = std::make_shared<InfiniteArea>(std::make_shared<Hdr>("scenes/diningroom/textures/spaichingen_hill_4k.hdr"));
-
 	// Shape
 	Transform tran;
-	auto light = new TriangleMesh(light_material, "scenes/diningroom/models/light.obj", tran);
-	auto floor = new TriangleMesh(floor_material, "scenes/diningroom/models/floor.obj", tran);
-	auto wall = new TriangleMesh(wall_material, "scenes/diningroom/models/wall.obj", tran);
-	auto light2 = new TriangleMesh(light2_window_material, "scenes/diningroom/models/light2.obj", tran);
-	auto window = new TriangleMesh(light2_window_material, "scenes/diningroom/models/window.obj", tran);
-	auto wall_picture = new TriangleMesh(wall_picture_material, "scenes/diningroom/models/wall_picture.obj", tran);
-	auto table1 = new TriangleMesh(table1_chair_spoon_material, "scenes/diningroom/models/table1.obj", tran);
-	auto table2 = new TriangleMesh(table2_material, "scenes/diningroom/models/table2.obj", tran);
-	auto chair1 = new TriangleMesh(table1_chair_spoon_material, "scenes/diningroom/models/chair1.obj", tran);
-	auto chair2 = new TriangleMesh(chair2_material, "scenes/diningroom/models/chair2.obj", tran);
-	auto chair3 = new TriangleMesh(chair3_material, "scenes/diningroom/models/chair3.obj", tran);
-	auto cup = new TriangleMesh(cup_material, "scenes/diningroom/models/cup.obj", tran);
-	auto plate = new TriangleMesh(plate_material, "scenes/diningroom/models/plate.obj", tran);
-	auto spoon = new TriangleMesh(table1_chair_spoon_material, "scenes/diningroom/models/spoon.obj", tran);
-	auto pot = new TriangleMesh(teapot_material, "scenes/diningroom/models/pot.obj", tran);
-	auto teapot = new TriangleMesh(teapot_material, "scenes/diningroom/models/teapot.obj", tran);
+	auto light = loader.LoadMesh(light_material, "scenes/diningroom/models/light.obj", tran);
+	auto floor = loader.LoadMesh(floor_material, "scenes/diningroom/models/floor.obj", tran);
+	auto wall = loader.LoadMesh(wall_material, "scenes/diningroom/models/wall.obj", tran);
+	auto light2 = loader.LoadMesh(light2_window_material, "scenes/diningroom/models/light2.obj", tran);
+	auto window = loader.LoadMesh(light2_window_material, "scenes/diningroom/models/window.obj", tran);
+	auto wall_picture = loader.LoadMesh(wall_picture_material, "scenes/diningroom/models/wall_picture.obj", tran);
+	auto table1 = loader.LoadMesh(table1_chair_spoon_material, "scenes/diningroom/models/table1.obj", tran);
+	auto table2 = loader.LoadMesh(table2_material, "scenes/diningroom/models/table2.obj", tran);
+	auto chair1 = loader.LoadMesh(table1_chair_spoon_material, "scenes/diningroom/models/chair1.obj", tran);
+	auto chair2 = loader.LoadMesh(chair2_material, "scenes/diningroom/models/chair2.obj", tran);
+	auto chair3 = loader.LoadMesh(chair3_material, "scenes/diningroom/models/chair3.obj", tran);
+	auto cup = loader.LoadMesh(cup_material, "scenes/diningroom/models/cup.obj", tran);
+	auto plate = loader.LoadMesh(plate_material, "scenes/diningroom/models/plate.obj", tran);
+	auto spoon = loader.LoadMesh(table1_chair_spoon_material, "scenes/diningroom/models/spoon.obj", tran);
+	auto pot = loader.LoadMesh(teapot_material, "scenes/diningroom/models/pot.obj", tran);
+	auto teapot = loader.LoadMesh(teapot_material, "scenes/diningroom/models/teapot.obj", tran);
+
+	// Light
+	auto envlight = std::make_shared<InfiniteArea>(spaichingen_hill_4k_texture.get());
 
 	// Camera
 	auto camera = std::make_shared<Pinhole>(Point3f(-1.0f, 2.0f, 9.0f), Point3f(-1.0f, 2.0f, 0.0f), Vector3f(0.0f, 1.0f, 0.0f), 1.0f, 45.0f, (float)Width / (float)Height);
@@ -166,29 +177,30 @@ std::shared_ptr<Renderer> TestScenes::Diningroom_EnvironmentLight() {
 	auto sampler = std::make_shared<Independent>();
 
 	// Scene
-	auto scene = std::make_shared<Scene>(rtc_device);
+	auto scene = std::make_shared<Scene>(embree);
 	scene->AddLight(envlight);
-	scene->AddShape(light);
-	scene->AddShape(floor);
-	scene->AddShape(wall);
-	scene->AddShape(light2);
-	scene->AddShape(window);
-	scene->AddShape(wall_picture);
-	scene->AddShape(table1);
-	scene->AddShape(table2);
-	scene->AddShape(chair1);
-	scene->AddShape(chair2);
-	scene->AddShape(chair3);
-	scene->AddShape(cup);
-	scene->AddShape(plate);
-	scene->AddShape(spoon);
-	scene->AddShape(pot);
-	scene->AddShape(teapot);
+	scene->AddShape(light.get());
+	scene->AddShape(floor.get());
+	scene->AddShape(wall.get());
+	scene->AddShape(light2.get());
+	scene->AddShape(window.get());
+	scene->AddShape(wall_picture.get());
+	scene->AddShape(table1.get());
+	scene->AddShape(table2.get());
+	scene->AddShape(chair1.get());
+	scene->AddShape(chair2.get());
+	scene->AddShape(chair3.get());
+	scene->AddShape(cup.get());
+	scene->AddShape(plate.get());
+	scene->AddShape(spoon.get());
+	scene->AddShape(pot.get());
+	scene->AddShape(teapot.get());
 	scene->SetCamera(camera);
 	scene->Commit();
 
 	// Integrator
-	auto integrator = std::make_shared<VolumetricPathTracing>(scene, sampler, filter, Width, Height, 64);
+	IntegratorParams integratorParams{ type, scene, sampler, filter, Width, Height, 64 };
+	auto integrator = Integrator::Create(integratorParams);
 
 	// ToneMapper
 	auto tone = std::make_shared<Reinhard>();
@@ -197,15 +209,19 @@ std::shared_ptr<Renderer> TestScenes::Diningroom_EnvironmentLight() {
 	auto post = std::make_shared<PostProcessing>(tone, 0.5f);
 
 	// Renderer
-	auto renderer = std::make_shared<Renderer>(integrator, post);
+	RendererParams rendererParams{ integrator, post };
 
-	return renderer;
+	return rendererParams;
 }
 
-std::shared_ptr<Renderer> TestScenes::Subsurface() {
+RendererParams TestScenes::Subsurface(IntegratorType type, const EmbreeParams& embree) {
 	int Width = 800;
 	int Height = 800;
 
+	// Asset
+	AssetLoader loader;
+	auto spruit_sunrise_4k_texture = loader.LoadTexture<Hdr>("scenes/subsurface/textures/spruit_sunrise_4k.hdr");
+
 	// Medium
 	float sigma_a[3] = { 0.0030f, 0.0034f, 0.046f };
 	float sigma_s[3] = { 2.29f, 2.39f, 1.97f };
@@ -225,17 +241,17 @@ std::shared_ptr<Renderer> TestScenes::Subsurface() {
 	auto red = std::make_shared<Diffuse>(std::make_shared<Constant>(Spectrum::FromRGB(diffuse_red)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
 	auto green = std::make_shared<Diffuse>(std::make_shared<Constant>(Spectrum::FromRGB(diffuse_green)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)));
 
-	// Light
-	auto envlight = std::make_shared<InfiniteArea>(std::make_shared<Hdr>("scenes/subsurface/textures/spruit_sunrise_4k.hdr"));
-
 	// Shape
 	Transform tran;
 	Transform tran_b = Transform::Rotate(0.0f, 180.0f, 0.0f);
-	auto buddha = new TriangleMesh(buddha_material, "scenes/subsurface/models/buddha.obj", tran_b, NULL, medium);
-	auto cbox_back = new TriangleMesh(white, "scenes/subsurface/models/cbox_back.obj", tran_b);
-	auto cbox_floor = new TriangleMesh(white, "scenes/subsurface/models/cbox_floor.obj", tran);
-	auto cbox_greenwall = new TriangleMesh(red, "scenes/subsurface/models/cbox_greenwall.obj", tran);
+	auto buddha = loader.LoadMesh(buddha_material, "scenes/subsurface/models/buddha.obj", tran_b, NULL, medium);
+	auto cbox_back = loader.LoadMesh(white, "scenes/subsurface/models/cbox_back.obj", tran_b);
+	auto cbox_floor = loader.LoadMesh(white, "scenes/subsurface/models/cbox_floor.obj", tran);
+	auto cbox_greenwall = loader.LoadMesh(red, "scenes/subsurface/models/cbox_greenwall.obj", tran);
 	
+	// Light
+	auto envlight = std::make_shared<InfiniteArea>(spruit_sunrise_4k_texture.get());
+
 	// Camera
 	auto camera = std::make_shared<Pinhole>(Point3f(0.0f, 0.0f, 55.0f), Point3f(0.0f, 0.0f, 0.0f), Vector3f(0.0f, 1.0f, 0.0f), 1.0f, 60.0f, 
 		(float)Width / (float)Height);
@@ -247,17 +263,18 @@ std::shared_ptr<Renderer> TestScenes::Subsurface() {
 	auto sampler = std::make_shared<Independent>();
 
 	// Scene
-	auto scene = std::make_shared<Scene>(rtc_device);
+	auto scene = std::make_shared<Scene>(embree);
 	scene->AddLight(envlight);
-	scene->AddShape(buddha);
-	scene->AddShape(cbox_back);
-	scene->AddShape(cbox_floor);
-	scene->AddShape(cbox_greenwall);
+	scene->AddShape(buddha.get());
+	scene->AddShape(cbox_back.get());
+	scene->AddShape(cbox_floor.get());
+	scene->AddShape(cbox_greenwall.get());
 	scene->SetCamera(camera);
 	scene->Commit();
 
 	// Integrator
-	auto integrator = std::make_shared<VolumetricPathTracing>(scene, sampler, filter, Width, Height, 2048);
+	IntegratorParams integratorParams{ type, scene, sampler, filter, Width, Height, 2048 };
+	auto integrator = Integrator::Create(integratorParams);
 
 	// ToneMapper
 	auto tone = std::make_shared<ACES>();
@@ -266,15 +283,23 @@ std::shared_ptr<Renderer> TestScenes::Subsurface() {
 	auto post = std::make_shared<PostProcessing>(tone, 0.0f);
 
 	// Renderer
-	auto renderer = std::make_shared<Renderer>(integrator, post);
+	RendererParams rendererParams{ integrator, post };
 
-	return renderer;
+	return rendererParams;
 }
 
-std::shared_ptr<Renderer> TestScenes::Surface() {
+RendererParams TestScenes::Surface(IntegratorType type, const EmbreeParams& embree) {
 	int Width = 1280;
 	int Height = 720;
 
+	// Asset
+	AssetLoader loader;
+	auto clock_albedo_texture = loader.LoadTexture<Image>("scenes/surface/textures/clock_albedo.bmp");
+	auto clock_roughness_texture = loader.LoadTexture<Image>("scenes/surface/textures/clock_roughness.bmp");
+	auto clock_metallic_texture = loader.LoadTexture<Image>("scenes/surface/textures/clock_metallic.bmp");
+	auto clock_normal_texture = loader.LoadTexture<Image>("scenes/surface/textures/clock_normal.bmp");
+	auto spruit_sunrise_4k_texture = loader.LoadTexture<Hdr>("scenes/surface/textures/spruit_sunrise_4k.hdr");
+
 	// Material
 	float albedo[3] = { 1.0f, 1.0f, 1.0f };
 	float diffuse[3] = { 0.4f, 0.4f, 0.4f };
@@ -288,9 +313,9 @@ std::shared_ptr<Renderer> TestScenes::Surface() {
 		std::make_shared<Constant>(Spectrum::FromRGB(roughness2)), Spectrum::FromRGB(eta), Spectrum::FromRGB(k));
 	auto dragon_material = std::make_shared<ClearcoatedConductor>(conductor, std::make_shared<Constant>(Spectrum::FromRGB(roughness)),
 		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.0f);
-	auto clock_material = std::make_shared<MetalWorkflow>(std::make_shared<Image>("scenes/surface/textures/clock_albedo.bmp"), 
-		std::make_shared<Image>("scenes/surface/textures/clock_roughness.bmp"), std::make_shared<Image>("scenes/surface/textures/clock_roughness.bmp"),
-		std::make_shared<Image>("scenes/surface/textures/clock_metallic.bmp"), std::make_shared<Image>("scenes/surface/textures/clock_normal.bmp"));
+	auto clock_material = std::make_shared<MetalWorkflow>(clock_albedo_texture.get(), 
+		clock_roughness_texture.get(), clock_roughness_texture.get(),
+		clock_metallic_texture.get(), clock_normal_texture.get());
 	auto dielctric = std::make_shared<Dielectric>(std::make_shared<Constant>(Spectrum::FromRGB(albedo)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)),
 		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.5f, 1.0f);
 	auto dielctric2 = std::make_shared<Dielectric>(std::make_shared<Constant>(Spectrum::FromRGB(albedo)), std::make_shared<Constant>(Spectrum::FromRGB(roughness2)),
@@ -299,15 +324,15 @@ std::shared_ptr<Renderer> TestScenes::Surface() {
 	auto plane_material = std::make_shared<Plastic>(std::make_shared<Constant>(Spectrum::FromRGB(diffuse)), std::make_shared<Constant>(Spectrum::FromRGB(specular)),
 		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.5f, 1.0f, true);
 
-	// Light
-	auto envlight = std::make_shared<InfiniteArea>(std::make_shared<Hdr>("scenes/surface/textures/spruit_sunrise_4k.hdr"));
-
 	// Shape
 	Transform tran;
-	auto clock = new TriangleMesh(clock_material, "scenes/surface/models/clock.obj", tran);
-	auto dragon = new TriangleMesh(dragon_material, "scenes/surface/models/dragon.obj", tran);
-	auto teapot = new TriangleMesh(teapot_material, "scenes/surface/models/teapot.obj", tran);
-	auto plane = new TriangleMesh(plane_material, "scenes/surface/models/plane.obj", tran);
+	auto clock = loader.LoadMesh(clock_material, "scenes/surface/models/clock.obj", tran);
+	auto dragon = loader.LoadMesh(dragon_material, "scenes/surface/models/dragon.obj", tran);
+	auto teapot = loader.LoadMesh(teapot_material, "scenes/surface/models/teapot.obj", tran);
+	auto plane = loader.LoadMesh(plane_material, "scenes/surface/models/plane.obj", tran);
+
+	// Light
+	auto envlight = std::make_shared<InfiniteArea>(spruit_sunrise_4k_texture.get());
 
 	// Camera
 	auto camera = std::make_shared<Pinhole>(Point3f(15.0f, 7.5f, 0.0f), Point3f(0.0f, 0.0f, 0.0f), Vector3f(0.0f, 1.0f, 0.0f), 1.0f, 60.0f,
@@ -320,17 +345,18 @@ std::shared_ptr<Renderer> TestScenes::Surface() {
 	auto sampler = std::make_shared<SimpleSobol>(0);
 
 	// Scene
-	auto scene = std::make_shared<Scene>(rtc_device);
+	auto scene = std::make_shared<Scene>(embree);
 	scene->AddLight(envlight);
-	scene->AddShape(clock);
-	scene->AddShape(dragon);
-	scene->AddShape(teapot);
-	scene->AddShape(plane);
+	scene->AddShape(clock.get());
+	scene->AddShape(dragon.get());
+	scene->AddShape(teapot.get());
+	scene->AddShape(plane.get());
 	scene->SetCamera(camera);
 	scene->Commit();
 
 	// Integrator
-	auto integrator = std::make_shared<VolumetricPathTracing>(scene, sampler, filter, Width, Height, 64);
+	IntegratorParams integratorParams{ type, scene, sampler, filter, Width, Height, 64 };
+	auto integrator = Integrator::Create(integratorParams);
 
 	// ToneMapper
 	auto tone = std::make_shared<Uncharted2>();
@@ -339,15 +365,18 @@ std::shared_ptr<Renderer> TestScenes::Surface() {
 	auto post = std::make_shared<PostProcessing>(tone, 0.0f);
 
 	// Renderer
-	auto renderer = std::make_shared<Renderer>(integrator, post);
+	RendererParams rendererParams{ integrator, post };
 
-	return renderer;
+	return rendererParams;
 }
 
-std::shared_ptr<Renderer> TestScenes::Cornellbox() {
+RendererParams TestScenes::Cornellbox(IntegratorType type, const EmbreeParams& embree) {
 	int Width = 800;
 	int Height = 800;
 
+	// Asset
+	AssetLoader loader;
+
 	// Medium
 	float sigma_a[3] = { 0.25f, 0.5f, 0.75f };
 	float sigma_s[3] = { 1.0f, 1.0f, 1.0f };
@@ -375,13 +404,13 @@ std::shared_ptr<Renderer> TestScenes::Cornellbox() {
 
 	// Shape
 	Transform tran;
-	auto cbox_ceiling = new TriangleMesh(white, "scenes/cornellbox/models/cbox_ceiling.obj", tran, medium, medium);
-	auto cbox_back = new TriangleMesh(white, "scenes/cornellbox/models/cbox_back.obj", tran, medium, medium);
-	auto cbox_floor = new TriangleMesh(white, "scenes/cornellbox/models/cbox_floor.obj", tran, medium, medium);
-	auto cbox_greenwall = new TriangleMesh(green, "scenes/cornellbox/models/cbox_greenwall.obj", tran, medium, medium);
-	auto cbox_redwall = new TriangleMesh(red, "scenes/cornellbox/models/cbox_redwall.obj", tran, medium, medium);
-	auto cbox_largebox = new TriangleMesh(white, "scenes/cornellbox/models/cbox_largebox.obj", tran, medium);
-	auto cbox_smallbox = new TriangleMesh(white, "scenes/cornellbox/models/cbox_smallbox.obj", tran, medium);
+	auto cbox_ceiling = loader.LoadMesh(white, "scenes/cornellbox/models/cbox_ceiling.obj", tran, medium, medium);
+	auto cbox_back = loader.LoadMesh(white, "scenes/cornellbox/models/cbox_back.obj", tran, medium, medium);
+	auto cbox_floor = loader.LoadMesh(white, "scenes/cornellbox/models/cbox_floor.obj", tran, medium, medium);
+	auto cbox_greenwall = loader.LoadMesh(green, "scenes/cornellbox/models/cbox_greenwall.obj", tran, medium, medium);
+	auto cbox_redwall = loader.LoadMesh(red, "scenes/cornellbox/models/cbox_redwall.obj", tran, medium, medium);
+	auto cbox_largebox = loader.LoadMesh(white, "scenes/cornellbox/models/cbox_largebox.obj", tran, medium);
+	auto cbox_smallbox = loader.LoadMesh(white, "scenes/cornellbox/models/cbox_smallbox.obj", tran, medium);
 // 	auto sphere = new Sphere(dielctric, Point3f(6.0f, -15.0f, 0.0f), 8.0f, medium);
 // 	auto sphere2 = new Sphere(dielctric, Point3f(-6.0f, 15.0f, 0.0f), 8.0f, medium);
 
@@ -396,22 +425,23 @@ std::shared_ptr<Renderer> TestScenes::Cornellbox() {
 	auto sampler = std::make_shared<Independent>();
 
 	// Scene
-	auto scene = std::make_shared<Scene>(rtc_device);
+	auto scene = std::make_shared<Scene>(embree);
 	scene->AddLight(light);
-	scene->AddShape(cbox_redwall);
-	scene->AddShape(cbox_back);
-	scene->AddShape(cbox_ceiling);
-	scene->AddShape(cbox_floor);
-	scene->AddShape(cbox_greenwall);
-	scene->AddShape(cbox_largebox);
-	scene->AddShape(cbox_smallbox);
+	scene->AddShape(cbox_redwall.get());
+	scene->AddShape(cbox_back.get());
+	scene->AddShape(cbox_ceiling.get());
+	scene->AddShape(cbox_floor.get());
+	scene->AddShape(cbox_greenwall.get());
+	scene->AddShape(cbox_largebox.get());
+	scene->AddShape(cbox_smallbox.get());
 // 	scene->AddShape(sphere);
 // 	scene->AddShape(sphere2);
 	scene->SetCamera(camera);
 	scene->Commit();
 
 	// Integrator
-	auto integrator = std::make_shared<VolumetricPathTracing>(scene, sampler, filter, Width, Height, 16);
+	IntegratorParams integratorParams{ type, scene, sampler, filter, Width, Height, 16 };
+	auto integrator = Integrator::Create(integratorParams);
 
 	// ToneMapper
 	auto tone = std::make_shared<Uncharted2>();
@@ -420,15 +450,33 @@ std::shared_ptr<Renderer> TestScenes::Cornellbox() {
 	auto post = std::make_shared<PostProcessing>(tone, 0.0f);
 
 	// Renderer
-	auto renderer = std::make_shared<Renderer>(integrator, post);
+	RendererParams rendererParams{ integrator, post };
 
-	return renderer;
+	return rendererParams;
 }
 
-std::shared_ptr<Renderer> TestScenes::Camera_high() {
+RendererParams TestScenes::Camera_high(IntegratorType type, const EmbreeParams& embree) {
 	int Width = 1280;
 	int Height = 720;
 
+	// Asset
+	AssetLoader loader;
+	auto camera_01_body_diff_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_body_diff_8k.png");
+	auto camera_01_body_roughness_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_body_roughness_8k.png");
+	auto camera_01_body_metallic_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_body_metallic_8k.png");
+	auto camera_01_body_nor_gl_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_body_nor_gl_8k.png");
+	auto camera_01_lens_body_diff_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_lens_body_diff_8k.png");
+	auto camera_01_lens_body_roughness_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_lens_body_roughness_8k.png");
+	auto camera_01_lens_body_metallic_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_lens_body_metallic_8k.png");
+	auto camera_01_lens_body_nor_gl_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_lens_body_nor_gl_8k.png");
+	auto camera_01_strap_diff_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_strap_diff_8k.png");
+	auto camera_01_strap_roughness_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_strap_roughness_8k.png");
+	auto camera_01_strap_metallic_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_strap_metallic_8k.png");
+	auto camera_01_strap_nor_gl_8k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/Camera_01_strap_nor_gl_8k.png");
+	auto weathered_brown_planks_diff_16k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/weathered_brown_planks_diff_16k.jpg");
+	auto weathered_brown_planks_nor_gl_16k_texture = loader.LoadTexture<Image>("scenes/camera_high/textures/weathered_brown_planks_nor_gl_16k.png");
+	auto sunny_vondelpark_8k_texture = loader.LoadTexture<Hdr>("scenes/camera_high/textures/sunny_vondelpark_8k.hdr");
+
 	// Material
 	float specular[3] = { 1.0f, 1.0f, 1.0f };
 	float albedo[3] = { 1.0f, 1.0f, 1.0f }; 
@@ -439,35 +487,35 @@ std::shared_ptr<Renderer> TestScenes::Camera_high() {
 	float eta[3] = { 1.0f, 1.0f, 1.0f };
 	float k[3] = { 1.0f, 1.0f, 1.0f };
 
-	auto camera_body_material = std::make_shared<MetalWorkflow>(std::make_shared<Image>("scenes/camera_high/textures/Camera_01_body_diff_8k.png"),
-		std::make_shared<Image>("scenes/camera_high/textures/Camera_01_body_roughness_8k.png"), std::make_shared<Image>("scenes/camera_high/textures/Camera_01_body_roughness_8k.png"),
-		std::make_shared<Image>("scenes/camera_high/textures/Camera_01_body_metallic_8k.png"), std::make_shared<Image>("scenes/camera_high/textures/Camera_01_body_nor_gl_8k.png"));
-	auto camera_lens_body_material = std::make_shared<MetalWorkflow>(std::make_shared<Image>("scenes/camera_high/textures/Camera_01_lens_body_diff_8k.png"),
-		std::make_shared<Image>("scenes/camera_high/textures/Camera_01_lens_body_roughness_8k.png"), std::make_shared<Image>("scenes/camera_high/textures/Camera_01_lens_body_roughness_8k.png"),
-		std::make_shared<Image>("scenes/camera_high/textures/Camera_01_lens_body_metallic_8k.png"), std::make_shared<Image>("scenes/camera_high/textures/Camera_01_lens_body_nor_gl_8k.png"));
-	auto camera_strap_material = std::make_shared<MetalWorkflow>(std::make_shared<Image>("scenes/camera_high/textures/Camera_01_strap_diff_8k.png"),
-		std::make_shared<Image>("scenes/camera_high/textures/Camera_01_strap_roughness_8k.png"), std::make_shared<Image>("scenes/camera_high/textures/Camera_01_strap_roughness_8k.png"),
-		std::make_shared<Image>("scenes/camera_high/textures/Camera_01_strap_metallic_8k.png"), std::make_shared<Image>("scenes/camera_high/textures/Camera_01_strap_nor_gl_8k.png"));
+	auto camera_body_material = std::make_shared<MetalWorkflow>(camera_01_body_diff_8k_texture.get(),
+		camera_01_body_roughness_8k_texture.get(), camera_01_body_roughness_8k_texture.get(),
+		camera_01_body_metallic_8k_texture.get(), camera_01_body_nor_gl_8k_texture.get());
+	auto camera_lens_body_material = std::make_shared<MetalWorkflow>(camera_01_lens_body_diff_8k_texture.get(),
+		camera_01_lens_body_roughness_8k_texture.get(), camera_01_lens_body_roughness_8k_texture.get(),
+		camera_01_lens_body_metallic_8k_texture.get(), camera_01_lens_body_nor_gl_8k_texture.get());
+	auto camera_strap_material = std::make_shared<MetalWorkflow>(camera_01_strap_diff_8k_texture.get(),
+		camera_01_strap_roughness_8k_texture.get(), camera_01_strap_roughness_8k_texture.get(),
+		camera_01_strap_metallic_8k_texture.get(), camera_01_strap_nor_gl_8k_texture.get());
 	auto camera_lens_glass_material = std::make_shared<ThinDielectric>(std::make_shared<Constant>(Spectrum::FromRGB(albedo)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 
 		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.5f, 1.0f);
 	auto camera_lens_glass2_material = std::make_shared<Dielectric>(std::make_shared<Constant>(Spectrum::FromRGB(albedo)), std::make_shared<Constant>(Spectrum::FromRGB(roughness2)),
 		std::make_shared<Constant>(Spectrum::FromRGB(roughness2)), 1.5f, 1.0f);
 	auto camera_lens_material = std::make_shared<Mixture>(camera_lens_glass_material, camera_lens_glass2_material, 0.7f);
-	auto camera_backdrop_material = std::make_shared<MetalWorkflow>(std::make_shared<Image>("scenes/camera_high/textures/weathered_brown_planks_diff_16k.jpg"),
-		std::make_shared<Image>("scenes/camera_high/textures/weathered_brown_planks_nor_gl_16k.png"), std::make_shared<Image>("scenes/camera_high/textures/weathered_brown_planks_nor_gl_16k.png"),
-		std::make_shared<Constant>(Spectrum::FromRGB(metallic)), std::make_shared<Image>("scenes/camera_high/textures/weathered_brown_planks_nor_gl_16k.png"));
-
-	// Light
-	auto envlight = std::make_shared<InfiniteArea>(std::make_shared<Hdr>("scenes/camera_high/textures/sunny_vondelpark_8k.hdr"), 1.0f);
+	auto camera_backdrop_material = std::make_shared<MetalWorkflow>(weathered_brown_planks_diff_16k_texture.get(),
+		weathered_brown_planks_nor_gl_16k_texture.get(), weathered_brown_planks_nor_gl_16k_texture.get(),
+		std::make_shared<Constant>(Spectrum::FromRGB(metallic)), weathered_brown_planks_nor_gl_16k_texture.get());
 
 	// Shape
 	Transform tran;
-	auto floor = new TriangleMesh(camera_backdrop_material, "scenes/camera_high/models/floor.obj", tran);
-	auto camera_strap1 = new TriangleMesh(camera_strap_material, "scenes/camera_high/models/Mesh.00000.obj", tran);
-	auto camera_lens_body = new TriangleMesh(camera_lens_body_material, "scenes/camera_high/models/Mesh.00001.obj", tran);
-	auto camera_lens = new TriangleMesh(camera_lens_material, "scenes/camera_high/models/Mesh.00002.obj", tran);
-	auto camera_body = new TriangleMesh(camera_body_material, "scenes/camera_high/models/Mesh.00003.obj", tran);
-	auto camera_strap2 = new TriangleMesh(camera_strap_material, "scenes/camera_high/models/Mesh.00004.obj", tran);
+	auto floor = loader.LoadMesh(camera_backdrop_material, "scenes/camera_high/models/floor.obj", tran);
+	auto camera_strap1 = loader.LoadMesh(camera_strap_material, "scenes/camera_high/models/Mesh.00000.obj", tran);
+	auto camera_lens_body = loader.LoadMesh(camera_lens_body_material, "scenes/camera_high/models/Mesh.00001.obj", tran);
+	auto camera_lens = loader.LoadMesh(camera_lens_material, "scenes/camera_high/models/Mesh.00002.obj", tran);
+	auto camera_body = loader.LoadMesh(camera_body_material, "scenes/camera_high/models/Mesh.00003.obj", tran);
+	auto camera_strap2 = loader.LoadMesh(camera_strap_material, "scenes/camera_high/models/Mesh.00004.obj", tran);
+
+	// Light
+	auto envlight = std::make_shared<InfiniteArea>(sunny_vondelpark_8k_texture.get(), 1.0f);
 
 	// Camera
 	auto camera = std::make_shared<Thinlens>(Point3f(15.0f, 15.0f, 33.0f), Point3f(0.0f, 0.0f, 0.0f), Vector3f(0.0f, 1.0f, 0.0f), 1.0f, 45.0f,
@@ -480,19 +528,20 @@ std::shared_ptr<Renderer> TestScenes::Camera_high() {
 	auto sampler = std::make_shared<Independent>();
 
 	// Scene
-	auto scene = std::make_shared<Scene>(rtc_device);
+	auto scene = std::make_shared<Scene>(embree);
 	scene->AddLight(envlight);
-	scene->AddShape(floor);
-	scene->AddShape(camera_strap1);
-	scene->AddShape(camera_strap2);
-	scene->AddShape(camera_lens_body);
-	scene->AddShape(camera_lens);
-	scene->AddShape(camera_body);
+	scene->AddShape(floor.get());
+	scene->AddShape(camera_strap1.get());
+	scene->AddShape(camera_strap2.get());
+	scene->AddShape(camera_lens_body.get());
+	scene->AddShape(camera_lens.get());
+	scene->AddShape(camera_body.get());
 	scene->SetCamera(camera);
 	scene->Commit();
 
 	// Integrator
-	auto integrator = std::make_shared<VolumetricPathTracing>(scene, sampler, filter, Width, Height, 1024);
+	IntegratorParams integratorParams{ type, scene, sampler, filter, Width, Height, 1024 };
+	auto integrator = Integrator::Create(integratorParams);
 
 	// ToneMapper
 	auto tone = std::make_shared<Reinhard>();
@@ -501,7 +550,86 @@ std::shared_ptr<Renderer> TestScenes::Camera_high() {
 	auto post = std::make_shared<PostProcessing>(tone, 0.0f);
 
 	// Renderer
-	auto renderer = std::make_shared<Renderer>(integrator, post);
+	RendererParams rendererParams{ integrator, post };
+
+	return rendererParams;
+}
+
+RendererParams TestScenes::Instancing(IntegratorType type, const EmbreeParams& embree) {
+	int Width = 1280;
+	int Height = 640;
+
+	// Asset
+	AssetLoader loader;
+
+	// Material
+	float diffuse[3] = { 0.6f, 0.6f, 0.6f };
+	float specular[3] = { 1.0f, 1.0f, 1.0f };
+	float red[3] = { 0.63f, 0.065f, 0.05f };
+	float green[3] = { 0.14f, 0.45f, 0.091f };
+	float blue[3] = { 0.1f, 0.2f, 0.6f };
+	float roughness[3] = { 0.1f };
+	float roughness2[3] = { 0.3f };
+	float radiance[3] = { 12.0f, 12.0f, 10.0f };
+	auto light_material = std::make_shared<DiffuseLight>(Spectrum::FromRGB(radiance));
+	auto floor_material = std::make_shared<Diffuse>(std::make_shared<Constant>(Spectrum::FromRGB(diffuse)), std::make_shared<Constant>(Spectrum::FromRGB(roughness2)));
+	auto red_material = std::make_shared<Plastic>(std::make_shared<Constant>(Spectrum::FromRGB(red)), std::make_shared<Constant>(Spectrum::FromRGB(specular)),
+		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.45f, 1.0f, true);
+	auto green_material = std::make_shared<Plastic>(std::make_shared<Constant>(Spectrum::FromRGB(green)), std::make_shared<Constant>(Spectrum::FromRGB(specular)),
+		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.45f, 1.0f, true);
+	auto blue_material = std::make_shared<Plastic>(std::make_shared<Constant>(Spectrum::FromRGB(blue)), std::make_shared<Constant>(Spectrum::FromRGB(specular)),
+		std::make_shared<Constant>(Spectrum::FromRGB(roughness)), std::make_shared<Constant>(Spectrum::FromRGB(roughness)), 1.45f, 1.0f, true);
+
+	// Shape
+	// The prototype is only referenced by the instances, it is not added to the scene itself
+	auto teapot = loader.LoadMesh(red_material, "scenes/diningroom/models/teapot.obj", Transform());
+	// Moves the center of the teapot's base to the origin and scales it up
+	Transform base = Transform::Scale(2.0f, 2.0f, 2.0f) * Transform::Translate(0.745f, -0.9f, 1.94f);
+	auto teapot1 = new Instance(red_material, teapot.get(), Transform::Translate(-5.0f, 0.0f, 0.0f) * base);
+	auto teapot2 = new Instance(green_material, teapot.get(), Transform::Translate(-2.5f, 0.0f, 0.0f) * Transform::Rotate(0.0f, 90.0f, 0.0f) * base);
+	auto teapot3 = new Instance(blue_material, teapot.get(), Transform::Scale(1.4f, 0.6f, 1.0f) * base);
+	// Mirroring transforms, the normals have to stay on the outside
+	auto teapot4 = new Instance(green_material, teapot.get(), Transform::Translate(2.5f, 0.0f, 0.0f) * Transform::Scale(-1.0f, 1.0f, 1.0f) * base);
+	auto teapot5 = new Instance(red_material, teapot.get(), Transform::Translate(5.0f, 0.0f, 0.0f) * Transform::Rotate(0.0f, 45.0f, 0.0f) * Transform::Scale(1.0f, 1.0f, -1.0f) * base);
+	auto floor = new Quad(floor_material, Point3f(-20.0f, 0.0f, -20.0f), Vector3f(0.0f, 0.0f, 40.0f), Vector3f(40.0f, 0.0f, 0.0f));
+
+	// Light
+	auto light = std::make_shared<QuadArea>(new Quad(light_material, Point3f(-3.0f, 8.0f, -2.0f), Vector3f(6.0f, 0.0f, 0.0f), Vector3f(0.0f, 0.0f, 4.0f)));
+
+	// Camera
+	auto camera = std::make_shared<Pinhole>(Point3f(0.0f, 4.0f, 10.0f), Point3f(0.0f, 0.5f, 0.0f), Vector3f(0.0f, 1.0f, 0.0f), 1.0f, 45.0f,
+		(float)Width / (float)Height);
+
+	// Filter
+	auto filter = std::make_shared<Gaussian>();
+
+	// Sampler
+	auto sampler = std::make_shared<Independent>();
+
+	// Scene
+	auto scene = std::make_shared<Scene>(embree);
+	scene->AddLight(light);
+	scene->AddShape(floor);
+	scene->AddShape(teapot1);
+	scene->AddShape(teapot2);
+	scene->AddShape(teapot3);
+	scene->AddShape(teapot4);
+	scene->AddShape(teapot5);
+	scene->SetCamera(camera);
+	scene->Commit();
+
+	// Integrator
+	IntegratorParams integratorParams{ type, scene, sampler, filter, Width, Height, 64 };
+	auto integrator = Integrator::Create(integratorParams);
+
+	// ToneMapper
+	auto tone = std::make_shared<Uncharted2>();
+
+	// PostProcessing
+	auto post = std::make_shared<PostProcessing>(tone, 0.0f);
+
+	// Renderer
+	RendererParams rendererParams{ integrator, post };
 
-	return renderer;
+	return rendererParams;
 }
@@ -4,15 +4,17 @@
 #include "Renderer.h"
 
 namespace TestScenes{
-	std::shared_ptr<Renderer> Diningroom_MeshLight();
+	RendererParams Diningroom_MeshLight(IntegratorType type = IntegratorType::VolumetricPathTracingIntegrator, const EmbreeParams& embree = EmbreeParams());
 
-	std::shared_ptr<Renderer> Diningroom_EnvironmentLight();
+	RendererParams Diningroom_EnvironmentLight(IntegratorType type = IntegratorType::VolumetricPathTracingIntegrator, const EmbreeParams& embree = EmbreeParams());
 
-	std::shared_ptr<Renderer> Subsurface();
+	RendererParams Subsurface(IntegratorType type = IntegratorType::VolumetricPathTracingIntegrator, const EmbreeParams& embree = EmbreeParams());
 
-	std::shared_ptr<Renderer> Surface();
+	RendererParams Surface(IntegratorType type = IntegratorType::VolumetricPathTracingIntegrator, const EmbreeParams& embree = EmbreeParams());
 
-	std::shared_ptr<Renderer> Cornellbox();
+	RendererParams Cornellbox(IntegratorType type = IntegratorType::VolumetricPathTracingIntegrator, const EmbreeParams& embree = EmbreeParams());
 
-	std::shared_ptr<Renderer> Camera_high();
+	RendererParams Camera_high(IntegratorType type = IntegratorType::VolumetricPathTracingIntegrator, const EmbreeParams& embree = EmbreeParams());
+
+	RendererParams Instancing(IntegratorType type = IntegratorType::VolumetricPathTracingIntegrator, const EmbreeParams& embree = EmbreeParams());
 }
\ No newline at end of file
@@ -7,7 +7,7 @@ Spectrum Constant::GetColor(const Point2f& uv) {
 }
 
 Image::Image(const std::string& filepath) : Texture(TextureType::ImageTexture) {
-	stbi_set_flip_vertically_on_load(false);
+	stbi_set_flip_vertically_on_load_thread(false);
 	data = stbi_load(filepath.c_str(), &nx, &ny, &nn, 0);
 	if (data == NULL) {
 		std::cerr << "Texture is null:" + filepath + "\n";
@@ -65,7 +65,7 @@ Spectrum Image::GetColor(const Point2f& uv) {
 }
 
 Hdr::Hdr(const std::string& filepath) : Texture(TextureType::HdrTexture) {
-	stbi_set_flip_vertically_on_load(true);
+	stbi_set_flip_vertically_on_load_thread(true);
 	data = stbi_loadf(filepath.c_str(), &nx, &ny, &nn, 0);
 	if (data == NULL) {
 		std::cerr << "Texture is null:" + filepath + "\n";
@@ -23,6 +23,18 @@ Vector3f Transform::TransformVector(const Vector3f& v) const {
 	return transformMatrix * Vector4f(v, 0.0f);
 }
 
+Vector3f Transform::TransformNormal(const Vector3f& n) const {
+	if (identity) {
+		return n;
+	}
+
+	return NormalMatrix() * n;
+}
+
+Matrix3f Transform::NormalMatrix() const {
+	return glm::transpose(glm::inverse(Matrix3f(transformMatrix)));
+}
+
 Matrix4f Transform::Mat() const {
 	return transformMatrix;
 }
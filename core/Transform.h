@@ -12,8 +12,23 @@ public:
 
 	Vector3f TransformVector(const Vector3f& v) const;
 
+	// Normals go through the inverse transpose, so they stay perpendicular under non-uniform scale
+	Vector3f TransformNormal(const Vector3f& n) const;
+
+	Matrix3f NormalMatrix() const;
+
 	Matrix4f Mat() const;
 
+	// also true for an explicit identity matrix
+	inline bool IsIdentity() const {
+		return identity || transformMatrix == Matrix4f(1.0f);
+	}
+
+	// Mirroring transforms turn the winding of a triangle around
+	inline bool SwapsHandedness() const {
+		return !identity && glm::determinant(Matrix3f(transformMatrix)) < 0.0f;
+	}
+
 	Transform Inverse() const;
 
 	Transform operator*(const Transform& t) const;
@@ -14,13 +14,20 @@
 #include <memory>
 #include <string>
 #include <queue>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <atomic>
+#include <functional>
 #include <map>
+#include <unordered_map>
 #include <fstream>
 #include <vector>
 #include <sstream>
 #include <time.h>
-#include <glad/glad.h>
-#include <glfw/glfw3.h>
+#include <chrono>
 #include <glm/glm.hpp>
 #include <glm/gtx/optimum_pow.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -48,6 +55,7 @@ class Shape;
 class TriangleMesh;
 class Sphere;
 class Quad;
+class Instance;
 
 class Camera;
 class Pinhole;
@@ -97,6 +105,11 @@ class Gaussian;
 
 class Integrator;
 class VolumetricPathTracing;
+class WavefrontPathTracing;
+
+class TileScheduler;
+
+class Film;
 
 class Renderer;
 
@@ -140,25 +153,6 @@ constexpr float INV_PI = 1.0f / PI;
 constexpr float INV_2PI = 1.0f / (2.0f * PI);
 constexpr float INV_4PI = 1.0f / (4.0f * PI);
 
-struct MediumInterface {
-	MediumInterface() : in_medium(NULL), out_medium(NULL) {}
-
-	MediumInterface(std::shared_ptr<Medium> medium) : in_medium(medium), out_medium(medium) {}
-
-	MediumInterface(std::shared_ptr<Medium> inside, std::shared_ptr<Medium> outside) : in_medium(inside), out_medium(outside) {}
-
-	inline std::shared_ptr<Medium> GetMedium(bool frontFace) const {
-		if (frontFace) {
-			return out_medium;
-		}
-		else {
-			return in_medium;
-		}
-	}
-
-	std::shared_ptr<Medium> in_medium, out_medium;
-};
-
 struct IntersectionInfo {
 	float t;
 	Point2f uv;
@@ -168,8 +162,13 @@ struct IntersectionInfo {
 	bool frontFace;
 	int geomID;
 	int primID;
-	std::shared_ptr<Material> material;
-	MediumInterface mi;
+	int instID;// geomID of the instance, -1 for shapes placed directly
+	int materialID;// index into the material table of the scene, -1 for none
+	int inMediumID, outMediumID;// indices into the medium table of the scene, -1 for vacuum
+
+	inline int GetMediumID(bool front) const {
+		return front ? outMediumID : inMediumID;
+	}
 
 	inline void SetNormal(const Vector3f& dir, const Vector3f& ng, const Vector3f& ns) {
 		frontFace = glm::dot(dir, ng) < 0.0f;
@@ -181,6 +180,9 @@ struct IntersectionInfo {
 	}
 };
 
+// Copied per hit and per path, it must stay free of reference counted members
+static_assert(std::is_trivially_copyable<IntersectionInfo>::value, "IntersectionInfo must be trivially copyable");
+
 inline Vector3f ToLocal(const Vector3f& dir, const Vector3f& up) {
 	auto B = Vector3f(0.0f), C = Vector3f(0.0f);
 	if (std::abs(up.x) > std::abs(up.y)) {
@@ -245,7 +247,15 @@ inline Point3f GetHitPos(const RTCRayHit& rayhit) {
 	return org + dir * rayhit.ray.tfar;
 }
 
-inline RTCRay MakeRay(const Point3f& rayorg, const Vector3f& raydir, float tnear = 0.0f, float tfar = Infinity) {
+// Ray types as Embree mask bits, a shape is only hit by the ray types in its visibility
+enum RayVisibility : uint32_t {
+	CameraVisibility = 1 << 0,
+	ShadowVisibility = 1 << 1,
+	IndirectVisibility = 1 << 2,
+	AllVisibility = CameraVisibility | ShadowVisibility | IndirectVisibility,
+};
+
+inline RTCRay MakeRay(const Point3f& rayorg, const Vector3f& raydir, float tnear = 0.0f, float tfar = Infinity, uint32_t mask = RayVisibility::AllVisibility) {
 	RTCRay ray;
 
 	ray.org_x = rayorg.x;
@@ -256,11 +266,14 @@ inline RTCRay MakeRay(const Point3f& rayorg, const Vector3f& raydir, float tnear
 	ray.dir_z = raydir.z;
 	ray.tnear = tnear;
 	ray.tfar = tfar;
+	ray.time = 0.0f;
+	ray.mask = mask;
+	ray.flags = 0;
 
 	return ray;
 }
 
-inline RTCRayHit MakeRayHit(const Point3f& rayorg, const Vector3f& raydir, float tnear = 0.0f, float tfar = Infinity) {
+inline RTCRayHit MakeRayHit(const Point3f& rayorg, const Vector3f& raydir, float tnear = 0.0f, float tfar = Infinity, uint32_t mask = RayVisibility::AllVisibility) {
 	RTCRayHit rayhit;
 
 	rayhit.ray.org_x = rayorg.x;
@@ -271,6 +284,9 @@ inline RTCRayHit MakeRayHit(const Point3f& rayorg, const Vector3f& raydir, float
 	rayhit.ray.dir_z = raydir.z;
 	rayhit.ray.tnear = tnear;
 	rayhit.ray.tfar = tfar;
+	rayhit.ray.time = 0.0f;
+	rayhit.ray.mask = mask;
+	rayhit.ray.flags = 0;
 	rayhit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
 	rayhit.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
 
@@ -287,6 +303,51 @@ inline RTCRayHit MakeRayHit(const RTCRay& ray) {
 	return rayhit;
 }
 
+// Lanes of a primary ray packet
+constexpr int PacketSize = 8;
+
+inline void SetRayHit8(RTCRayHit8& packet, int i, const Point3f& rayorg, const Vector3f& raydir, float tnear = 0.0f, float tfar = Infinity, uint32_t mask = RayVisibility::AllVisibility) {
+	packet.ray.org_x[i] = rayorg.x;
+	packet.ray.org_y[i] = rayorg.y;
+	packet.ray.org_z[i] = rayorg.z;
+	packet.ray.dir_x[i] = raydir.x;
+	packet.ray.dir_y[i] = raydir.y;
+	packet.ray.dir_z[i] = raydir.z;
+	packet.ray.tnear[i] = tnear;
+	packet.ray.tfar[i] = tfar;
+	packet.ray.time[i] = 0.0f;
+	packet.ray.mask[i] = mask;
+	packet.ray.flags[i] = 0;
+	packet.hit.geomID[i] = RTC_INVALID_GEOMETRY_ID;
+	packet.hit.instID[0][i] = RTC_INVALID_GEOMETRY_ID;
+}
+
+inline RTCRayHit GetRayHit(const RTCRayHit8& packet, int i) {
+	RTCRayHit rayhit;
+
+	rayhit.ray.org_x = packet.ray.org_x[i];
+	rayhit.ray.org_y = packet.ray.org_y[i];
+	rayhit.ray.org_z = packet.ray.org_z[i];
+	rayhit.ray.dir_x = packet.ray.dir_x[i];
+	rayhit.ray.dir_y = packet.ray.dir_y[i];
+	rayhit.ray.dir_z = packet.ray.dir_z[i];
+	rayhit.ray.tnear = packet.ray.tnear[i];
+	rayhit.ray.tfar = packet.ray.tfar[i];
+	rayhit.ray.time = packet.ray.time[i];
+	rayhit.ray.mask = packet.ray.mask[i];
+	rayhit.ray.flags = packet.ray.flags[i];
+	rayhit.hit.Ng_x = packet.hit.Ng_x[i];
+	rayhit.hit.Ng_y = packet.hit.Ng_y[i];
+	rayhit.hit.Ng_z = packet.hit.Ng_z[i];
+	rayhit.hit.u = packet.hit.u[i];
+	rayhit.hit.v = packet.hit.v[i];
+	rayhit.hit.primID = packet.hit.primID[i];
+	rayhit.hit.geomID = packet.hit.geomID[i];
+	rayhit.hit.instID[0] = packet.hit.instID[0][i];
+
+	return rayhit;
+}
+
 inline void SetRayOrg(RTCRayHit& rayhit, const Point3f& org) {
 	rayhit.ray.org_x = org.x;
 	rayhit.ray.org_y = org.y;
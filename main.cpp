@@ -1,14 +1,19 @@
 #include "TestScenes.h"
+#include "Interactive.h"
 
 int main() {
 //	SampledSpectrum::Init();
 
-	auto renderer = TestScenes::Diningroom_MeshLight();
-//	auto renderer = TestScenes::Diningroom_EnvironmentLight();
-//	auto renderer = TestScenes::Subsurface();
-//	auto renderer = TestScenes::Surface();
-//	auto renderer = TestScenes::Cornellbox();
-//	auto renderer = TestScenes::Camera_high();
+	auto params = TestScenes::Diningroom_MeshLight();
+//	auto params = TestScenes::Diningroom_EnvironmentLight();
+//	auto params = TestScenes::Subsurface();
+//	auto params = TestScenes::Surface();
+//	auto params = TestScenes::Cornellbox();
+//	auto params = TestScenes::Camera_high();
+//	auto params = TestScenes::Instancing();
+	// Blue-noise error makes the first few frames of the preview readable
+	params.integrator->SetSampler(Sampler::Create(SamplerParams{ SamplerType::BlueNoiseSampler, 0 }));
+	auto renderer = std::make_shared<Interactive>(params.integrator, params.post);
 	renderer->Run();
 
 	return 0;
@@ -34,8 +39,7 @@ int main() {
 // 	//Pinhole camera(Point3f(0.0f, 1.0f, 4.0f), Point3f(0.0f), Vector3f(0.0f, 1.0f, 0.0f), 1.0f, 55.0f, (float)Width / (float)Height, medium);
 // 	//Thinlens camera2(Point3f(10.0f, 8.0f, 10.0f), Point3f(0.0f), Vector3f(0.0f, 1.0f, 0.0f), 1.0f, 60.0f, (float)Width / (float)Height, 2.0f);
 // 	//PostProcessing post(std::make_shared<Reinhard>(), 0.0f);
-// 	RTCDevice rtc_device = rtcNewDevice(NULL);
-// 	Scene scene(rtc_device);
+// 	Scene scene;
 // 
 // 	float specular[3] = { 1.0f, 1.0f, 1.0f };
 // 	float albedo[3] = { 0.8f, 0.2f, 0.3f };
@@ -143,7 +147,7 @@ int main() {
 // 
 // 	// Create renderer
 // 	RendererParams rendererParams{ integrator, post };
-// 	auto renderer = Renderer::Create(rendererParams);
+// 	auto renderer = std::make_shared<Interactive>(rendererParams.integrator, rendererParams.post);
 // 
 // 	renderer->Run();
 // 
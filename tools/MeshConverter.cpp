@@ -0,0 +1,37 @@
+#include "Shape.h"
+
+// Converts OBJ meshes to the binary mesh format TriangleMesh maps at startup:
+// MeshConverter mesh.obj [mesh.obj ...], each mesh is written next to its OBJ as mesh.drm
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cout << "Usage: MeshConverter mesh.obj [mesh.obj ...]" << std::endl;
+
+		return 1;
+	}
+
+	int failed = 0;
+	for (int i = 1; i < argc; i++) {
+		std::filesystem::path input = argv[i];
+		std::filesystem::path output = input;
+		output.replace_extension(".drm");
+		if (input.extension() == ".drm") {
+			std::cout << "Skip " << input.string() << ", it is already a binary mesh" << std::endl;
+			failed++;
+
+			continue;
+		}
+
+		// welded and untransformed, a placed mesh gets its transform when it is loaded.
+		// Always parsed from the OBJ, a mapped output file would be truncated while it is still in use
+		TriangleMesh mesh(NULL, input.string(), Transform(), NULL, NULL, false);
+		if (!mesh.SaveBinary(output.string())) {
+			std::cout << "Write " << output.string() << " failed!" << std::endl;
+			failed++;
+
+			continue;
+		}
+		std::cout << "Write " << output.string() << ": " << std::filesystem::file_size(output) / 1024 << " KB" << std::endl;
+	}
+
+	return failed == 0 ? 0 : 1;
+}
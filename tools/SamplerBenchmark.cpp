@@ -0,0 +1,113 @@
+#include "Sampler.h"
+
+// Microbenchmark of the per-pixel cost of the samplers:
+// SamplerBenchmark [-size pixels] [-spp samples] [-dims dimensions] [-first sample index of the pass]
+constexpr int Repeats = 3;
+
+// The reseeded mt19937 the Independent sampler used before the counter-based generator
+class ReseededMT {
+public:
+	float Get1() {
+		return std::uniform_real_distribution<float>(0.0f, FloatOneMinusEpsilon)(rng);
+	}
+
+	void SetPixel(int x, int y, uint64_t index) {
+		uint64_t pixel = (static_cast<uint64_t>(y) << 32) | static_cast<uint32_t>(x);
+		rng.seed(static_cast<uint32_t>(MixBits(pixel ^ MixBits(index))));
+	}
+
+private:
+	std::mt19937 rng;
+};
+
+template<typename Func>
+void Measure(const std::string& name, int size, int spp, int dims, uint64_t first, Func func) {
+	double best = Infinity;
+	double sum = 0.0;
+	for (int r = 0; r < Repeats; r++) {
+		sum = 0.0;
+		auto t1 = std::chrono::steady_clock::now();
+		// Same order as RenderImage, all samples of a pixel in a row
+		for (int j = 0; j < size; j++) {
+			for (int i = 0; i < size; i++) {
+				for (int s = 0; s < spp; s++) {
+					sum += func(i, j, first + s, dims);
+				}
+			}
+		}
+		best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count());
+	}
+
+	double pixelSamples = static_cast<double>(size) * size * spp;
+	std::cout << std::fixed << std::setprecision(2) << std::setw(14) << name << "    " << best * 1e9 / pixelSamples << " ns/pixel sample    "
+		<< best * 1e9 / (pixelSamples * dims) << " ns/dimension    mean " << std::setprecision(4) << sum / (pixelSamples * dims) << std::endl;
+}
+
+void MeasureSampler(const std::string& name, std::shared_ptr<Sampler> sampler, int size, int spp, int dims, uint64_t first) {
+	Measure(name, size, spp, dims, first, [&](int x, int y, uint64_t s, int d) {
+		// Like RenderImage, a pixel is set up once and then steps to its next samples
+		if (s == first) {
+			sampler->SetSampleIndex(s);
+			sampler->SetPixel(x, y);
+		}
+		else {
+			sampler->NextSample();
+		}
+		float sum = 0.0f;
+		for (int k = 0; k < d; k++) {
+			// Same dimension layout as a path, camera block first and then one block per bounce
+			if (k >= CameraDimensions && (k - CameraDimensions) % BounceDimensions == 0) {
+				sampler->StartBounce((k - CameraDimensions) / BounceDimensions);
+			}
+			sum += sampler->Get1();
+		}
+
+		return sum;
+	});
+}
+
+int main(int argc, char* argv[]) {
+	int size = 256;
+	int spp = 16;
+	int dims = 32;
+	uint64_t first = 0;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string arg = argv[i];
+		if (arg == "-size") {
+			size = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "-spp") {
+			spp = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "-dims") {
+			dims = std::atoi(argv[i + 1]);
+		}
+		else if (arg == "-first") {
+			first = std::strtoull(argv[i + 1], NULL, 10);
+		}
+		else {
+			std::cout << "Unknown argument " << arg << std::endl;
+
+			return 1;
+		}
+	}
+	std::cout << size << "x" << size << " pixels, " << spp << " spp from sample " << first << ", " << dims << " dimensions" << std::endl;
+
+	ReseededMT mt;
+	Measure("mt19937", size, spp, dims, first, [&](int x, int y, uint64_t s, int d) {
+		mt.SetPixel(x, y, s);
+		float sum = 0.0f;
+		for (int k = 0; k < d; k++) {
+			sum += mt.Get1();
+		}
+
+		return sum;
+	});
+
+	MeasureSampler("Independent", Sampler::Create(SamplerParams{ SamplerType::IndependentSampler, 0 }), size, spp, dims, first);
+	MeasureSampler("SimpleSobol", Sampler::Create(SamplerParams{ SamplerType::SimpleSobolSampler, 0 }), size, spp, dims, first);
+	MeasureSampler("OwenSobol", Sampler::Create(SamplerParams{ SamplerType::OwenSobolSampler, 0 }), size, spp, dims, first);
+
+	return 0;
+}